@@ -0,0 +1,91 @@
+/*
+ * Time per lookup of PatLabelIndex compared with the PAT lookup (string comparison over all labels of the object, as in pat::Tau::tauID),
+ * on a tau-like layout of 80 labels of which the 20 tau IDs of LeptonAnalyzer are read for every object
+ * Every 1000th object has its labels in a different order, to check that value() falls back to the PAT lookup for objects deviating from the
+ * layout seen by validate()
+ * The objects are read 100 times, as 100 events with the same collection
+ * Usage: benchmarkPatLabelIndex [<number of objects>]
+ */
+#include "heavyNeutrino/multilep/interface/PatLabelIndex.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    double secondsSince(const std::chrono::steady_clock::time_point& start){
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    float patLookup(const PatLabelIndex::LabelValues& pairs, const std::string& label){
+        for(const auto& pair : pairs){
+            if(pair.first == label) return pair.second;
+        }
+        throw cms::Exception("Key not found") << "Label " << label << " not found";
+    }
+}
+
+int main(int argc, char* argv[]){
+    const unsigned nObjects = argc > 1 ? std::atoi(argv[1]) : 10000;
+    const unsigned nEvents  = 100;
+
+    std::vector<std::string> labels;
+    for(const std::string& discriminant : {"byIsolationMVArun2v1", "byIsolationMVArun2v2", "byDeepTau2017v1", "byPFTau"}){
+        for(const std::string& working : {"VVLoose", "VLoose", "Loose", "Medium", "Tight", "VTight", "VVTight"}){
+            for(const std::string& decayModes : {"DBoldDMwLT", "DBnewDMwLT", "PWoldDMwLT"}){
+                if(labels.size() < 60) labels.push_back("by" + working + discriminant.substr(2) + decayModes);
+            }
+        }
+    }
+    std::vector<std::string> readLabels;
+    for(unsigned l = 0; l < 20; ++l){
+        readLabels.push_back("readTauId" + std::to_string(l) + "IsolationMVArun2v1DBoldDMwLT");
+        labels.insert(labels.begin() + 4*l, readLabels.back());
+    }
+
+    std::mt19937 engine(12345);
+    std::uniform_real_distribution<float> uniform(0., 1.);
+    std::vector<PatLabelIndex::LabelValues> objects(nObjects);
+    for(unsigned o = 0; o < nObjects; ++o){
+        for(const std::string& label : labels) objects[o].emplace_back(label, uniform(engine));
+        if(o % 1000 == 999) std::shuffle(objects[o].begin(), objects[o].end(), engine);
+    }
+
+    try {
+        auto start = std::chrono::steady_clock::now();
+        double patSum = 0.;
+        for(unsigned e = 0; e < nEvents; ++e){
+            for(const auto& object : objects){
+                for(const std::string& label : readLabels) patSum += patLookup(object, label);
+            }
+        }
+        const double patTime = secondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        PatLabelIndex index(readLabels);
+        double indexSum = 0.;
+        for(unsigned e = 0; e < nEvents; ++e){
+            index.validate(objects.front());
+            for(const auto& object : objects){
+                for(unsigned l = 0; l < readLabels.size(); ++l) indexSum += index.value(object, l);
+            }
+        }
+        const double indexTime = secondsSince(start);
+
+        if(patSum != indexSum) throw cms::Exception("benchmarkPatLabelIndex") << "PatLabelIndex and the PAT lookup differ";
+
+        const double nLookups = (double) nEvents*nObjects*readLabels.size();
+        std::cout << "PatLabelIndex: " << nObjects << " objects identical to the PAT lookup, " << std::setprecision(3)
+                  << 1e9*indexTime/nLookups << " ns/lookup (index) vs " << 1e9*patTime/nLookups << " ns/lookup (PAT)" << std::endl;
+    } catch(const cms::Exception& exception){
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,41 @@
+/*
+ * Evaluates a lepton MVA forest on the features in a binary file and writes the responses, used by test/testing/compareLeptonMvaForests.py
+ * Features: float32, per variable (features[variable*nLeptons + lepton]), responses: float64 per lepton
+ * Usage: evaluateLeptonMvaForest <weight file> <features file> <responses file>
+ */
+#include "heavyNeutrino/multilep/interface/LeptonMvaForest.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+int main(int argc, char* argv[]){
+    if(argc != 4){
+        std::cerr << "Usage: " << argv[0] << " <weight file> <features file> <responses file>" << std::endl;
+        return 1;
+    }
+
+    try {
+        const std::string weightFile = argv[1];
+        LeptonMvaForest forest(weightFile, LeptonMvaForest::xmlVariableNames(weightFile), LeptonMvaForest::xmlOnly);
+
+        std::ifstream featureFile(argv[2], std::ios::binary);
+        std::vector<char> buffer((std::istreambuf_iterator<char>(featureFile)), std::istreambuf_iterator<char>());
+        const unsigned nLeptons = buffer.size()/(sizeof(float)*forest.nVariables());
+        if(!featureFile or nLeptons*sizeof(float)*forest.nVariables() != buffer.size()){
+            throw cms::Exception("evaluateLeptonMvaForest") << argv[2] << " does not hold " << forest.nVariables() << " float features per lepton";
+        }
+        std::vector<float> features(buffer.size()/sizeof(float));
+        std::copy(buffer.begin(), buffer.end(), reinterpret_cast<char*>(features.data()));
+
+        std::vector<double> mvas(nLeptons);
+        forest.evaluate(features.data(), nLeptons, mvas.data());
+        std::ofstream(argv[3], std::ios::binary).write(reinterpret_cast<const char*>(mvas.data()), mvas.size()*sizeof(double));
+    } catch(const cms::Exception& exception){
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,69 @@
+/*
+ * Writes the read-only caches of the lepton MVA forests (<weightFile>.cache) at install time, see setup.sh
+ * For every weight file the start-up time of parsing the xml is compared with mapping the new cache, and the responses of both are
+ * checked to be identical on random inputs (including NaN inputs)
+ * Usage: makeLeptonMvaCache <weight file> [<weight file> ...], see setup.sh for the call on all weight files
+ */
+#include "heavyNeutrino/multilep/interface/LeptonMvaForest.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+    double secondsSince(const std::chrono::steady_clock::time_point& start){
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char* argv[]){
+    if(argc < 2){
+        std::cerr << "Usage: " << argv[0] << " <weight file> [<weight file> ...]" << std::endl;
+        return 1;
+    }
+
+    try {
+        for(int a = 1; a < argc; ++a){
+            const std::string weightFile = argv[a];
+            const std::vector<std::string> variableNames = LeptonMvaForest::xmlVariableNames(weightFile);
+
+            auto start = std::chrono::steady_clock::now();
+            auto xmlForest = std::make_unique<LeptonMvaForest>(weightFile, variableNames, LeptonMvaForest::xmlOnly);
+            const double xmlTime = secondsSince(start);
+            xmlForest->writeCache();
+
+            start = std::chrono::steady_clock::now();
+            auto cachedForest = std::make_unique<LeptonMvaForest>(weightFile, variableNames);
+            const double cacheTime = secondsSince(start);
+            if(!cachedForest->fromCache()) throw cms::Exception("makeLeptonMvaCache") << "the cache written for " << weightFile << " is not used";
+
+            //identical responses on random inputs, features stored per variable as in LeptonMvaHelper
+            const unsigned nLeptons = 10000;
+            std::mt19937 engine(12345);
+            std::normal_distribution<float> gauss(0., 10.);
+            std::vector<float> features(variableNames.size()*nLeptons);
+            for(float& feature : features) feature = gauss(engine);
+            for(unsigned l = 0; l < nLeptons; l += 100) features[(l % variableNames.size())*nLeptons + l] = std::numeric_limits<float>::quiet_NaN();
+            std::vector<double> xmlMvas(nLeptons), cachedMvas(nLeptons);
+            xmlForest->evaluate(features.data(), nLeptons, xmlMvas.data());
+            cachedForest->evaluate(features.data(), nLeptons, cachedMvas.data());
+            if(std::memcmp(xmlMvas.data(), cachedMvas.data(), nLeptons*sizeof(double)) != 0){
+                throw cms::Exception("makeLeptonMvaCache") << "cached and xml forest differ for " << weightFile;
+            }
+
+            std::cout << weightFile << ".cache: start-up " << std::setprecision(3) << 1e3*xmlTime << " ms (xml) vs "
+                      << 1e3*cacheTime << " ms (cache)" << std::endl;
+        }
+    } catch(const cms::Exception& exception){
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
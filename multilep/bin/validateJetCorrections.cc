@@ -0,0 +1,261 @@
+/*
+ * Compares the jet energy corrections of JetCorrectionTable and the JEC class with the FactorizedJetCorrector for all shipped 2016 and 2017
+ * MC and DATA text files
+ *  - every correction text file on its own (L1FastJet, L1RC, L2Relative, L3Absolute, L2Residual and L2L3Residual; the Uncertainty files are no
+ *    corrections): the bin of JetCorrectionTable is compared with the first matching record (JetCorrectorParameters::binIndex), which decides
+ *    for overlapping and touching bins, and the correction with a FactorizedJetCorrector of that level
+ *  - the JEC class per era, level by level (the cumulative factors of getSubCorrections)
+ * The jets are random in eta, pt, rho and area (including pt and eta outside of the binning), plus jets on, just below and just above every bin
+ * edge (all combinations in two dimensions) and every clamp edge of the parameter variables; the bins and corrections are required to be identical
+ * The largest relative deviation and the time per jet of both are reported
+ * Usage: validateJetCorrections [<number of random jets per file>], run from anywhere in the release
+ */
+#include "heavyNeutrino/multilep/interface/JEC.h"
+#include "heavyNeutrino/multilep/interface/JetCorrectionTable.h"
+#include "CondFormats/JetMETObjects/interface/FactorizedJetCorrector.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    struct Jet {
+        float eta, pt, rho, area;
+
+        float& operator[](const JetCorrectionTable::Variable variable){
+            switch(variable){
+                case JetCorrectionTable::jetEta: return eta;
+                case JetCorrectionTable::jetPt:  return pt;
+                case JetCorrectionTable::jetA:   return area;
+                default:                         return rho;
+            }
+        }
+        std::array<float, JetCorrectionTable::nVariables> variables() const { return {{eta, pt, area, rho}}; }   //indexed by JetCorrectionTable::Variable
+    };
+
+    struct Era {
+        std::string   name;
+        bool          isData;
+        bool          is2017;
+        unsigned long run;                                                                               //a run of the era, see the run ranges in JEC.cc
+    };
+
+    const std::vector<Era> eras = {{"Summer16_07Aug2017_V9_MC",       false, false, 1},
+                                   {"Summer16_07Aug2017BCD_V9_DATA",  true,  false, 271658},
+                                   {"Summer16_07Aug2017EF_V9_DATA",   true,  false, 276812},
+                                   {"Summer16_07Aug2017GH_V9_DATA",   true,  false, 278809},
+                                   {"Fall17_17Nov2017_V6_MC",         false, true,  1},
+                                   {"Fall17_17Nov2017B_V6_DATA",      true,  true,  297020},
+                                   {"Fall17_17Nov2017C_V6_DATA",      true,  true,  299337},
+                                   {"Fall17_17Nov2017D_V6_DATA",      true,  true,  302030},
+                                   {"Fall17_17Nov2017E_V6_DATA",      true,  true,  303435},
+                                   {"Fall17_17Nov2017F_V6_DATA",      true,  true,  304911}};
+
+    const std::vector<std::string> correctionLevels = {"L1FastJet", "L1RC", "L2Relative", "L3Absolute", "L2Residual", "L2L3Residual"};  //not every era has all of them
+
+    struct Deviation {
+        unsigned differences = 0;
+        double   maximum     = 0.;                                                                       //largest relative deviation
+
+        bool add(const float value, const float reference){
+            if(value == reference) return false;
+            ++differences;
+            maximum = std::max(maximum, std::abs((double) value/reference - 1.));
+            return true;
+        }
+    };
+
+    double secondsSince(const std::chrono::steady_clock::time_point& start){
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    JetCorrectionTable::Variable variableIndex(const std::string& name){
+        if(name == "JetEta") return JetCorrectionTable::jetEta;
+        if(name == "JetPt")  return JetCorrectionTable::jetPt;
+        if(name == "JetA")   return JetCorrectionTable::jetA;
+        if(name == "Rho")    return JetCorrectionTable::rho;
+        throw cms::Exception("validateJetCorrections") << "Unsupported jet correction variable " << name;
+    }
+
+    std::vector<float> around(const float edge){
+        return {std::nextafter(edge, -std::numeric_limits<float>::infinity()), edge, std::nextafter(edge, std::numeric_limits<float>::infinity())};
+    }
+
+    //jets on, just below and just above the bin edges of every record (all combinations in two dimensions) and the clamp edges of its parameter variables
+    std::vector<Jet> edgeJets(const JetCorrectorParameters& parameters, const std::function<Jet()>& randomJet){
+        const JetCorrectorParameters::Definitions& definitions = parameters.definitions();
+        std::vector<JetCorrectionTable::Variable> binVariables, parVariables;
+        for(unsigned i = 0; i < definitions.nBinVar(); ++i) binVariables.push_back(variableIndex(definitions.binVar(i)));
+        for(unsigned i = 0; i < definitions.nParVar(); ++i) parVariables.push_back(variableIndex(definitions.parVar(i)));
+
+        std::vector<Jet> jets;
+        for(unsigned r = 0; r < parameters.size(); ++r){
+            const JetCorrectorParameters::Record& record = parameters.record(r);
+            std::vector<std::vector<float>> edges(binVariables.size());
+            for(unsigned i = 0; i < binVariables.size(); ++i){
+                for(float edge : {record.xMin(i), record.xMax(i)}){
+                    for(float value : around(edge)) edges[i].push_back(value);
+                }
+            }
+            for(float x : edges[0]){
+                for(unsigned k = 0; k < (binVariables.size() > 1 ? edges[1].size() : 1); ++k){
+                    Jet jet = randomJet();
+                    jet[binVariables[0]] = x;
+                    if(binVariables.size() > 1) jet[binVariables[1]] = edges[1][k];
+                    jets.push_back(jet);
+                }
+            }
+
+            //the clamp range of every parameter variable, with the binning variables in the middle of the bin
+            for(unsigned i = 0; i < parVariables.size(); ++i){
+                for(float edge : {record.parameters()[2*i], record.parameters()[2*i+1]}){
+                    for(float value : around(edge)){
+                        Jet jet = randomJet();
+                        for(unsigned b = 0; b < binVariables.size(); ++b) jet[binVariables[b]] = 0.5*(record.xMin(b) + record.xMax(b));
+                        jet[parVariables[i]] = value;
+                        jets.push_back(jet);
+                    }
+                }
+            }
+        }
+        return jets;
+    }
+}
+
+int main(int argc, char* argv[]){
+    const unsigned nRandomJets = argc > 1 ? std::atoi(argv[1]) : 100000;
+    const char* base = std::getenv("CMSSW_BASE");
+    if(base == nullptr){
+        std::cerr << argv[0] << ": CMSSW_BASE is not set, run cmsenv first" << std::endl;
+        return 1;
+    }
+    const std::string path = std::string(base) + "/src/heavyNeutrino/multilep/data/JEC/";
+
+    std::mt19937 engine(12345);
+    std::uniform_real_distribution<float> etaDistribution(-5.5, 5.5), logPtDistribution(0., std::log(8000.)), rhoDistribution(0., 70.), areaDistribution(0.2, 1.);
+    auto randomJet = [&](){ return Jet{etaDistribution(engine), std::exp(logPtDistribution(engine)), rhoDistribution(engine), areaDistribution(engine)}; };
+
+    bool identical = true;
+    try {
+        //every correction file on its own
+        unsigned nFiles = 0;
+        Deviation allFiles;
+        for(const Era& era : eras){
+            for(const std::string& level : correctionLevels){
+                const std::string fileName = era.name + "_" + level + "_AK4PFchs.txt";
+                if(!std::ifstream(path + fileName)) continue;
+                ++nFiles;
+
+                const JetCorrectorParameters parameters(path + fileName);
+                const JetCorrectionTable table(parameters);
+                FactorizedJetCorrector corrector(std::vector<JetCorrectorParameters>(1, parameters));
+
+                std::vector<Jet> jets = edgeJets(parameters, randomJet);
+                for(unsigned j = 0; j < nRandomJets; ++j) jets.push_back(randomJet());
+
+                unsigned binDifferences = 0;
+                Deviation deviation;
+                for(const Jet& jet : jets){
+                    const std::array<float, JetCorrectionTable::nVariables> variables = jet.variables();
+                    std::vector<float> binValues;
+                    for(unsigned i = 0; i < parameters.definitions().nBinVar(); ++i) binValues.push_back(variables[variableIndex(parameters.definitions().binVar(i))]);
+                    const int firstMatch = parameters.binIndex(binValues);
+                    const int bin        = table.bin(variables.data());
+
+                    corrector.setJetEta(jet.eta);
+                    corrector.setJetPt(jet.pt);
+                    corrector.setJetE(jet.pt*std::cosh(jet.eta));
+                    corrector.setJetA(jet.area);
+                    corrector.setRho(jet.rho);
+                    const float expected   = corrector.getCorrection();
+                    const float correction = table.correction(variables.data());
+
+                    if(bin != firstMatch and binDifferences++ < 10){
+                        std::cerr << fileName << ": jet (eta " << jet.eta << ", pt " << jet.pt << "): bin " << bin << " vs " << firstMatch << " (first matching record)" << std::endl;
+                    }
+                    if(deviation.add(correction, expected) and deviation.differences <= 10){
+                        std::cerr << fileName << ": jet (eta " << jet.eta << ", pt " << jet.pt << ", rho " << jet.rho << ", area " << jet.area << "): "
+                                  << std::setprecision(9) << correction << " vs " << expected << " (FactorizedJetCorrector)" << std::endl;
+                    }
+                }
+                identical = identical and binDifferences == 0 and deviation.differences == 0;
+                allFiles.differences += deviation.differences;
+                allFiles.maximum      = std::max(allFiles.maximum, deviation.maximum);
+
+                std::cout << "validateJetCorrections: " << fileName << ": " << jets.size() << " jets, " << binDifferences << " bin differences with the first matching record, "
+                          << deviation.differences << " differences with FactorizedJetCorrector (max relative deviation " << std::setprecision(3) << deviation.maximum << ")" << std::endl;
+            }
+        }
+        std::cout << "validateJetCorrections: " << nFiles << " correction files, " << allFiles.differences << " differences with FactorizedJetCorrector (max relative deviation "
+                  << std::setprecision(3) << allFiles.maximum << ")" << std::endl;
+
+        //the JEC class, level by level
+        for(const Era& era : eras){
+            std::vector<std::string> levelNames = {"L1FastJet", "L2Relative", "L3Absolute"};
+            if(era.isData) levelNames.push_back("L2L3Residual");
+            std::vector<JetCorrectorParameters> parameters;
+            for(const std::string& level : levelNames) parameters.emplace_back(path + era.name + "_" + level + "_AK4PFchs.txt");
+
+            std::vector<Jet> jets;
+            for(unsigned j = 0; j < nRandomJets; ++j) jets.push_back(randomJet());
+            for(const JetCorrectorParameters& level : parameters){
+                std::vector<Jet> edges = edgeJets(level, randomJet);
+                jets.insert(jets.end(), edges.cbegin(), edges.cend());
+            }
+
+            FactorizedJetCorrector corrector(parameters);
+            std::vector<std::vector<float>> reference(jets.size());
+            auto start = std::chrono::steady_clock::now();
+            for(unsigned j = 0; j < jets.size(); ++j){
+                corrector.setJetEta(jets[j].eta);
+                corrector.setJetPt(jets[j].pt);
+                corrector.setJetE(jets[j].pt*std::cosh(jets[j].eta));
+                corrector.setJetA(jets[j].area);
+                corrector.setRho(jets[j].rho);
+                reference[j] = corrector.getSubCorrections();
+            }
+            const double referenceTime = secondsSince(start);
+
+            JEC jec(path, era.isData, era.is2017, false);
+            jec.updateJEC(era.run);
+            std::vector<JEC::SubCorrections> corrections(jets.size());
+            start = std::chrono::steady_clock::now();
+            for(unsigned j = 0; j < jets.size(); ++j){
+                for(unsigned level = 0; level < JEC::nLevels; ++level){
+                    corrections[j][level] = jec.jetCorrection(jets[j].pt, jets[j].eta, jets[j].rho, jets[j].area, (JEC::Level) level);
+                }
+            }
+            const double tableTime = secondsSince(start)/JEC::nLevels;                                  //jetCorrection evaluates all levels for every call
+
+            Deviation deviation;
+            for(unsigned j = 0; j < jets.size(); ++j){
+                for(unsigned level = 0; level < JEC::nLevels; ++level){
+                    const float expected = reference[j][std::min(level, (unsigned) reference[j].size() - 1)];   //L2L3Residual equals L3Absolute for MC
+                    if(deviation.add(corrections[j][level], expected) and deviation.differences <= 10){
+                        std::cerr << era.name << ": jet (eta " << jets[j].eta << ", pt " << jets[j].pt << ", rho " << jets[j].rho << ", area " << jets[j].area
+                                  << "), level " << level << ": " << std::setprecision(9) << corrections[j][level] << " vs " << expected << " (FactorizedJetCorrector)" << std::endl;
+                    }
+                }
+            }
+            identical = identical and deviation.differences == 0;
+
+            std::cout << "validateJetCorrections: " << era.name << ": " << jets.size() << " jets, " << deviation.differences << " differences with FactorizedJetCorrector (max relative deviation "
+                      << std::setprecision(3) << deviation.maximum << "), " << 1e9*tableTime/jets.size() << " ns/jet (JEC) vs " << 1e9*referenceTime/jets.size() << " ns/jet (FactorizedJetCorrector)" << std::endl;
+        }
+    } catch(const cms::Exception& exception){
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+    return identical ? 0 : 1;
+}
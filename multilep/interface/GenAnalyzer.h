@@ -46,7 +46,12 @@ class GenAnalyzer {
     bool     _gen_lPassParentage[gen_nL_max];
     double   _gen_lMinDeltaR[gen_nL_max];
 
-    unsigned overlapEventType(const std::vector<reco::GenParticle>& genParticles, double ptCut, double etaCut) const;
+    struct OverlapConfig { double ptCut; double etaCut; };                                   //photon cuts of an overlap removal scheme
+    std::vector<OverlapConfig> overlapConfigs;                                                 //ttG and ZG, in the order of the event type branches
+    std::vector<unsigned>      overlapTypes;
+
+    void     overlapEventType(const std::vector<reco::GenParticle>& genParticles, const std::vector<OverlapConfig>& configs, std::vector<unsigned>& types) const;
+    unsigned overlapPhotonType(const reco::GenParticle& p, const std::vector<reco::GenParticle>& genParticles) const;
     double   getMinDeltaR(const reco::GenParticle& p, const std::vector<reco::GenParticle>& genParticles) const;
 
     multilep* multilepAnalyzer;
@@ -0,0 +1,57 @@
+#ifndef GEN_ANCESTRY_H
+#define GEN_ANCESTRY_H
+#include "DataFormats/HepMCCandidate/interface/GenParticle.h"
+
+#include <limits>
+#include <vector>
+
+/*
+ * Per-event summary of the decay chain (the particle itself and all its ancestors, following both mothers) of every gen particle
+ * Filled in a single memoised pass over the collection, each particle combining its own pdgId with the summaries of its mothers,
+ * such that the decay chain queries (provenance, parentage, ...) are lookups instead of recursive walks building a std::set per query
+ * As in the original decay chain, protons are not part of the chain; antiprotons are (they count for nonEmpty and the pdgId range), but not as light baryon
+ */
+class GenAncestry {
+  public:
+    enum Flag : unsigned {
+        boson       = 1u << 0,                                                                           //Z, W, H or Majorana heavy neutrino
+        bBaryon     = 1u << 1,
+        bMeson      = 1u << 2,
+        cBaryon     = 1u << 3,
+        cMeson      = 1u << 4,
+        sBaryon     = 1u << 5,
+        lightMeson  = 1u << 6,                                                                           //includes gluons
+        lightBaryon = 1u << 7,
+        pi0         = 1u << 8,
+        photon      = 1u << 9,
+        tau         = 1u << 10,
+        W           = 1u << 11,
+        quark       = 1u << 12,
+        nonEmpty    = 1u << 13,
+        uds         = sBaryon | lightMeson | lightBaryon
+    };
+
+    struct Chain {
+        unsigned flags              = 0;                                                                 //Flag for every type of particle found in the chain
+        int      maxPdgId           = std::numeric_limits<int>::min();                                   //signed pdgIds, only meaningful for non-empty chains
+        int      minPdgId           = std::numeric_limits<int>::max();
+        bool     onlyIncomingGluons = true;                                                              //no gluon in the chain has a quark in its own chain
+    };
+
+    GenAncestry(){};
+    ~GenAncestry(){};
+
+    void  fill(const std::vector<reco::GenParticle>&);
+    Chain chain(const reco::GenParticle&) const;                                                         //particles outside the collection are combined from their mothers
+    bool  inChain(const reco::GenParticle& gen, const unsigned flags) const { return chain(gen).flags & flags; }
+
+  private:
+    static unsigned particleFlags(const int pdgId);
+    Chain combine(const reco::GenParticle&) const;                                                       //from the own pdgId and the chains of the mothers
+    void  resolve(const unsigned index);
+
+    const std::vector<reco::GenParticle>* genParticles = nullptr;
+    std::vector<Chain>                    chains;
+    std::vector<unsigned char>            states;                                                        //0: not visited, 1: in progress, 2: done
+};
+#endif
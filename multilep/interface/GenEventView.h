@@ -0,0 +1,47 @@
+#ifndef GEN_EVENT_VIEW_H
+#define GEN_EVENT_VIEW_H
+#include "DataFormats/HepMCCandidate/interface/GenParticle.h"
+
+#include <map>
+#include <utility>
+#include <vector>
+
+/*
+ * Per-event view of the gen particles for the matching and isolation queries, avoiding a scan of the full collection per query
+ * The particles are bucketed by the selections of these queries, and every bucket is sorted in eta such that a query only visits
+ * the particles in an eta window around the direction of interest
+ * The candidates found in a window are returned in the order of the collection, such that the tie-breaking (first or last match)
+ * of the original loops over the collection is kept, and the queries return exactly the same particles
+ */
+class GenEventView {
+  public:
+    GenEventView(){};
+    ~GenEventView(){};
+
+    void fill(const std::vector<reco::GenParticle>&);
+    const std::vector<reco::GenParticle>& particles() const { return *genParticles; }
+
+    void   matchingCandidates(const unsigned absPdgId, const double eta, const double window, std::vector<unsigned>& indices) const; //see GenTools::considerForMatching
+    void   photonMatchingCandidates(const double eta, const double window, std::vector<unsigned>& indices) const;                      //status 1 or 71, any pdgId
+    double minDeltaR(const reco::GenParticle&) const;                                                                                   //see GenTools::getMinDeltaR
+
+    static constexpr float minDeltaRPtCut = 5;
+
+  private:
+    class EtaIndex {
+      public:
+        void clear(){ entries.clear(); }
+        void add(const double eta, const unsigned index){ entries.emplace_back(eta, index); }
+        void sort();
+        void query(const double eta, const double window, std::vector<unsigned>& indices) const;                                      //appends, unsorted
+        const std::vector<std::pair<double, unsigned>>& sorted() const { return entries; }
+      private:
+        std::vector<std::pair<double, unsigned>> entries;                                                  //eta and position in the collection
+    };
+
+    const std::vector<reco::GenParticle>* genParticles = nullptr;
+    std::map<unsigned, EtaIndex>          matchingBuckets;                                                 //by |pdgId|
+    EtaIndex                              photonMatching;
+    EtaIndex                              minDeltaRParticles;
+};
+#endif
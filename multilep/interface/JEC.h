@@ -6,6 +6,7 @@ class to apply JEC from txt files
 #define JEC_H
 
 //include c++ library classes
+#include <array>
 #include <map>
 #include <string>
 #include <vector>
@@ -14,19 +15,23 @@ class to apply JEC from txt files
 //include CMSSW classes
 #include "CondFormats/JetMETObjects/interface/JetCorrectorParameters.h"
 #include "CondFormats/JetMETObjects/interface/JetCorrectionUncertainty.h"
-#include "CondFormats/JetMETObjects/interface/FactorizedJetCorrector.h"
 #include "DataFormats/PatCandidates/interface/MET.h"
 #include "DataFormats/PatCandidates/interface/Jet.h"
 
+#include "heavyNeutrino/multilep/interface/JetCorrectionTable.h"
+
 class JEC {
     public:
-        JEC(const std::string& JECpath, const bool dataSample, const bool fall17Sample);
+        enum Level {L1FastJet, L2Relative, L3Absolute, L2L3Residual, nLevels};
+        typedef std::array<float, nLevels> SubCorrections;                                                                    // cumulative correction factor up to each level, L2L3Residual equals L3Absolute for MC
+
+        JEC(const std::string& JECpath, const bool dataSample, const bool fall17Sample, const bool fall18Sample);
         ~JEC();
 
-        void updateJEC(const unsigned long);
-        void setJEC(const std::string&);
+        void updateJEC(const unsigned long);                                                                                  // switch to the era of the run, cheap when the era does not change
 
-        double jetCorrection(double rawPt, double eta, double rho, double area, const std::string& level = "L3Absolute");     // this function returns, for a given jet the correction factor
+        double jetCorrection(double rawPt, double eta, double rho, double area, const Level level = L3Absolute);              // this function returns, for a given jet the correction factor
+        void   jetCorrections(const std::vector<pat::Jet>& jets, const double rho, std::vector<SubCorrections>& corrections) const; // all levels for all jets, the output vector is reused between calls
         double jetUncertainty(double pt, double eta);
         std::pair <double, double > correctedMETAndPhi(const pat::MET& met, const std::vector< pat::Jet >& jets, const double rho);
 
@@ -35,19 +40,22 @@ class JEC {
         bool isData;
         bool is2017;
         bool is2018;
-        std::string currentJEC; 
 
-        std::shared_ptr<FactorizedJetCorrector> jetCorrector;
-        std::shared_ptr<JetCorrectionUncertainty> jetUncertainties;
+        struct Era {
+            unsigned long firstRun;
+            std::string   name;                                                                                              // e.g. Summer16_07Aug2017BCD_V9_DATA
+            std::string   warning;                                                                                           // printed when switching to an era without JEC
+            std::vector<JetCorrectionTable> jetCorrectionLevels;                                                             // L1FastJet, L2Relative, L3Absolute (and L2L3Residual for data), empty until the era is used
+            std::shared_ptr<JetCorrectionUncertainty> jetUncertainties;
+        };
+        std::vector<Era> eras;                                                                                               // sorted in firstRun
+        const Era*       currentEra = nullptr;
 
         double px(double pt, double phi){ return pt*cos(phi); };
         double py(double pt, double phi){ return pt*sin(phi); };
-        std::vector<float> getSubCorrections(double rawPt, double eta, double rho, double area);
+        SubCorrections getSubCorrections(double rawPt, double eta, double rho, double area) const;
         std::pair<double, double> getMETCorrectionPxPy(double rawPt, double rawEta, double rawMuonSubtractedPt, double phi, double emf, double rho, double area);
 
-        //JEC naming 
-        std::string getJECRunName(const unsigned long);
-        std::string getJECName(const unsigned long);
-        
+        void setJEC(Era&);
 };
 #endif
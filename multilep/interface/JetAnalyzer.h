@@ -7,15 +7,20 @@
 #include "FWCore/Framework/interface/Event.h"
 
 #include "heavyNeutrino/multilep/plugins/multilep.h"
+#include "heavyNeutrino/multilep/interface/PatLabelIndex.h"
+#include "heavyNeutrino/multilep/interface/JetUncertaintySources.h"
 
 #include "TTree.h"
 
+#include <array>
+
 class multilep;
 
 class JetAnalyzer {
   friend class multilep;
   private:
     JetCorrectionUncertainty* jecUnc;
+    JetUncertaintySources*    jecSources = nullptr;                                                //only when split JEC uncertainties are requested
 
     static const unsigned nJets_max = 20;
 
@@ -23,6 +28,9 @@ class JetAnalyzer {
     double   _jetPt[nJets_max];
     double   _jetPt_JECUp[nJets_max];
     double   _jetPt_JECDown[nJets_max];
+    std::vector<std::array<double, nJets_max>> _jetPt_JECSourceUp;                                   //per source in jecSources
+    std::vector<std::array<double, nJets_max>> _jetPt_JECSourceDown;
+    std::vector<float>                         jecSourceUp, jecSourceDown;
     double   _jetSmearedPt[nJets_max];
     double   _jetSmearedPt_JECDown[nJets_max];
     double   _jetSmearedPt_JECUp[nJets_max];
@@ -65,7 +73,8 @@ class JetAnalyzer {
     double   _metPhiUnclUp;
     double   _metSignificance;
 
-    multilep* multilepAnalyzer;
+    multilep*     multilepAnalyzer;
+    PatLabelIndex bTagDiscriminators;                                                                //positions of the b-tag discriminators, see JetAnalyzer.cc for the labels
 
     bool jetIsLoose(const pat::Jet& jet, const bool is2017) const;
     bool jetIsTight(const pat::Jet& jet, const bool is2017) const;
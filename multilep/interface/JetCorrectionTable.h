@@ -0,0 +1,37 @@
+#ifndef JET_CORRECTION_TABLE_H
+#define JET_CORRECTION_TABLE_H
+#include <string>
+#include <vector>
+
+#include "CommonTools/Utils/interface/FormulaEvaluator.h"
+#include "CondFormats/JetMETObjects/interface/JetCorrectorParameters.h"
+
+/*
+ * One level of the jet energy corrections (L1FastJet, L2Relative, ...) from the JetCorrectorParameters of a text file, flattened for fast evaluation
+ * The bins are stored as sorted edges with a contiguous parameter block per bin, and looked up with a binary search in every binning dimension
+ * (the files are regular grids in eta, or in eta and pt with the pt binning varying per eta bin)
+ * The formula is compiled once with the same FormulaEvaluator as used by the SimpleJetCorrector, and the variables are clamped to the range
+ * of each bin in the same way, such that the corrections agree with the FactorizedJetCorrector (checked by bin/validateJetCorrections)
+ */
+class JetCorrectionTable {
+  public:
+    enum Variable {jetEta, jetPt, jetA, rho, nVariables};
+
+    JetCorrectionTable(const JetCorrectorParameters&);
+    ~JetCorrectionTable(){};
+
+    float correction(const float* variables) const;                                                     //variables indexed by Variable, 1 outside of the binning
+    int   bin(const float* variables) const;                                                            //record used for the variables (the first matching one, as JetCorrectorParameters::binIndex), -1 outside of the binning
+
+  private:
+
+    std::vector<Variable>      binVariables;
+    std::vector<Variable>      parVariables;
+    std::vector<float>         etaLow, etaHigh;                                                          //first binning dimension
+    std::vector<unsigned>      etaFirstBin;                                                              //first bin of every eta bin in the second binning dimension, size etaLow.size() + 1
+    std::vector<float>         low, high;                                                                //second binning dimension, empty for one-dimensional tables
+    std::vector<double>        parameters;                                                               //clamp range of the parameter variables and formula parameters, per bin
+    std::vector<unsigned>      parameterOffset;                                                          //size nBins + 1
+    reco::FormulaEvaluator     formula;
+};
+#endif
@@ -0,0 +1,29 @@
+#ifndef JET_UNCERTAINTY_SOURCES_H
+#define JET_UNCERTAINTY_SOURCES_H
+#include <string>
+#include <vector>
+
+/*
+ * Split JEC uncertainties from an UncertaintySources text file, for a list of sources
+ * All sources share the same eta bins and pt grid, so they are stored in one table with the values of all sources contiguous for every
+ * grid point: a jet needs one eta bin and pt interval lookup, after which every source is interpolated in a single loop
+ * The interpolation is the same as in JetCorrectionUncertainty (linear in pt, constant outside the pt grid, -999 outside the eta bins)
+ */
+class JetUncertaintySources {
+  public:
+    JetUncertaintySources(const std::string& fileName, const std::vector<std::string>& sources);
+    ~JetUncertaintySources(){};
+
+    unsigned           size() const                 { return sources.size(); }
+    const std::string& source(const unsigned s) const{ return sources[s]; }
+
+    void uncertainties(const float pt, const float eta, float* up, float* down) const;              //up and down uncertainty of every source, arrays of size()
+
+  private:
+    std::vector<std::string> sources;
+    std::vector<float>       etaLow, etaHigh;
+    std::vector<unsigned>    firstPoint;                                                              //first pt grid point of every eta bin, size etaLow.size() + 1
+    std::vector<float>       ptGrid;
+    std::vector<float>       values;                                                                  //per pt grid point: up uncertainty of all sources, followed by the down uncertainty of all sources
+};
+#endif
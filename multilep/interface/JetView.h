@@ -0,0 +1,64 @@
+#ifndef JET_VIEW_H
+#define JET_VIEW_H
+#include "DataFormats/PatCandidates/interface/Jet.h"
+#include "DataFormats/Candidate/interface/Candidate.h"
+#include "heavyNeutrino/multilep/interface/PackedTrackCache.h"
+#include "heavyNeutrino/multilep/interface/PatLabelIndex.h"
+
+#include "TLorentzVector.h"
+
+#include <vector>
+
+/*
+ * Per-event view of the jets considered for the lepton-jet association (pt > 5, |eta| < 3), in the order of the jet collection
+ * The kinematics, L1-corrected four-momenta and b-tag scores are unpacked once per event into flat arrays (structure of arrays),
+ * such that the closest-jet lookup and the lepton-aware jet kinematics are indexed reads instead of pat::Jet copies and string lookups
+ * The deltaR between every lepton and every jet is stored in a lepton x jet matrix, filled by associate() when the lepton is processed
+ * The daughter tracks of a jet passing the track quality selection are determined once per event, the first time the jet is the closest jet of a lepton,
+ * such that only the deltaR to the lepton-aware jet remains to be done per lepton
+ */
+class JetView {
+  public:
+    JetView();
+    ~JetView(){};
+
+    void fill(const std::vector<pat::Jet>&, PackedTrackCache& trackCache);                             //the track cache provides the daughter track quality
+    unsigned size() const { return jets.size(); }
+
+    void     associate(const unsigned l, const reco::Candidate& lepton);                                 //fill row l of the deltaR matrix
+    double   deltaR(const unsigned l, const unsigned j) const { return deltaRs[l*jets.size() + j]; }
+    unsigned closestJet(const unsigned l) const;                                                         //first jet with the smallest deltaR, 0 (= size()) when there are no jets
+
+    const pat::Jet&                      jet(const unsigned j) const      { return *jets[j]; }
+    double                               pt(const unsigned j) const       { return pts[j]; }
+    double                               eta(const unsigned j) const      { return etas[j]; }
+    double                               phi(const unsigned j) const      { return phis[j]; }
+    const reco::Candidate::LorentzVector& p4(const unsigned j) const      { return p4s[j]; }
+    const reco::Candidate::LorentzVector& l1P4(const unsigned j) const    { return l1P4s[j]; }
+    float                                csvV2(const unsigned j) const    { return csvV2s[j]; }
+    float                                deepCsvB(const unsigned j) const { return deepCsvBs[j]; }
+    float                                deepCsvBB(const unsigned j) const{ return deepCsvBBs[j]; }
+
+    unsigned selectedTrackMult(const unsigned j, const TLorentzVector& lepAwareJet);                    //selected daughter tracks within deltaR 0.4 of the lepton-aware jet
+
+  private:
+    void selectTracks(const unsigned j);
+
+    PatLabelIndex                               bTagDiscriminators;
+    PackedTrackCache*                           trackCache = nullptr;
+    std::vector<const pat::Jet*>                jets;
+    std::vector<double>                         pts;
+    std::vector<double>                         etas;
+    std::vector<double>                         phis;
+    std::vector<reco::Candidate::LorentzVector> p4s;
+    std::vector<reco::Candidate::LorentzVector> l1P4s;
+    std::vector<float>                          csvV2s;
+    std::vector<float>                          deepCsvBs;
+    std::vector<float>                          deepCsvBBs;
+    std::vector<double>                         deltaRs;                                                  //lepton-major, jets.size() entries per lepton
+    std::vector<int>                            trackBegins;                                              //range of the selected tracks of each jet, -1 when not yet selected
+    std::vector<int>                            trackEnds;
+    std::vector<double>                         trackEtas;                                                //as computed by TLorentzVector
+    std::vector<double>                         trackPhis;
+};
+#endif
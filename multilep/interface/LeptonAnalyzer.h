@@ -14,12 +14,14 @@
 //include other parts of the framework
 #include "heavyNeutrino/multilep/plugins/multilep.h"
 #include "heavyNeutrino/multilep/interface/LeptonMvaHelper.h"
+#include "heavyNeutrino/multilep/interface/PatLabelIndex.h"
 
 //include ROOT classes
 #include "TTree.h"
 
 //include c++ library classes
 #include <memory>                                                                                   //for std::shared_ptr
+#include <limits>
 
 
 /*
@@ -37,6 +39,9 @@ class LeptonAnalyzer {
     EffectiveAreas electronsEffectiveAreas;
     EffectiveAreas muonsEffectiveAreas;
 
+    PatLabelIndex electronIds;                                                                       //positions of the electron and tau IDs, see LeptonAnalyzer.cc for the labels
+    PatLabelIndex tauIds;
+
     static const unsigned nL_max = 20;                                                               //maximum number of particles stored
     unsigned _nL;                                                                                    //number of leptons
     unsigned _nMu;
@@ -89,6 +94,8 @@ class LeptonAnalyzer {
     float _lElectronMvaFall17Iso[nL_max];
     float _lElectronMvaFall17NoIso[nL_max];
     bool _lElectronPassEmu[nL_max];
+    bool _lElectronPassEmuNoHOverE[nL_max];                                                          //trigger emulation without the H/E cut and the H/E cut alone, not stored
+    bool _lElectronPassHOverE[nL_max];
     bool _lElectronPassConvVeto[nL_max];
     bool _lElectronChargeConst[nL_max];
     unsigned _lElectronMissingHits[nL_max];
@@ -96,6 +103,8 @@ class LeptonAnalyzer {
     double _lMuonSegComp[nL_max];                                                                     //muon speficic variables
     double _lMuonTrackPt[nL_max];
     double _lMuonTrackPtErr[nL_max];
+    bool _lMuonIsLoose[nL_max];                                                                      //POG muon flags used by the lepton IDs, not stored
+    bool _lMuonIsMedium[nL_max];
 
     bool _tauMuonVeto[nL_max];                                                                       //tau specific variables
     bool _tauEleVeto[nL_max];
@@ -140,66 +149,102 @@ class LeptonAnalyzer {
     unsigned _lProvenanceCompressed[nL_max];
     unsigned _lProvenanceConversion[nL_max];
 
+    double leptonDeltaR2s[nL_max][nL_max];                                                           //deltaR^2 between the stored leptons, filled together with their kinematics
+
+    bool isPreselected(const pat::Muon&, const reco::Vertex&) const;                                    //object preselection, shared by skim and fill phase
+    bool isPreselected(const pat::Electron&, const reco::Vertex&) const;
+    bool isPreselected(const pat::Tau&, const reco::Vertex&) const;
+
     template <typename Lepton> void fillLeptonGenVars(const Lepton& lepton, const std::vector<reco::GenParticle>& genParticles);
     void fillLeptonKinVars(const reco::Candidate&);
     void fillLeptonImpactParameters(const pat::Electron&, const reco::Vertex&);
     void fillLeptonImpactParameters(const pat::Muon&, const reco::Vertex&);
     void fillLeptonImpactParameters(const pat::Tau&, const reco::Vertex&);
     double tau_dz(const pat::Tau&, const reco::Vertex::Point&) const;
-    bool eleMuOverlap(const pat::Electron& ele, const bool* loose) const;
-    bool tauLightOverlap(const pat::Tau& tau, const bool* loose) const;
-    void fillLeptonJetVariables(const reco::Candidate&, edm::Handle<std::vector<pat::Jet>>&, const reco::Vertex&, const double rho);
+    unsigned muonOverlapIds(const unsigned l) const;                                                  //ids of the muons within deltaR 0.05 of electron l, as bits
+    bool tauLightOverlap(const unsigned l, const bool* loose) const;
+    void fillLeptonJetVariables(const reco::Candidate&);                                               //closest jet variables, from the per-event jet view
 
     // In leptonAnalyzerIso,cc
     double getRelIso03(const pat::Muon&, const double) const;
     double getRelIso03(const pat::Electron&, const double) const;
     double getRelIso04(const pat::Muon& mu, const double, const bool DeltaBeta=false) const;
-    double getRelIso(const reco::RecoCandidate&, edm::Handle<pat::PackedCandidateCollection>, double, double, const bool onlyCharged=false) const;
-    double getMiniIsolation(const reco::RecoCandidate&, edm::Handle<pat::PackedCandidateCollection>, double, double, double, double, bool onlyCharged=false) const;
+    struct IsolationSums { double ch = 0., pu = 0., nh = 0., ph = 0.; };                              //charged from PV, charged from PU, neutral hadrons, photons
+    void   getIsolationSums(const reco::RecoCandidate&, const double* coneSizes, IsolationSums* sums, const unsigned nCones) const;
+    double getRelIso(const reco::RecoCandidate&, const IsolationSums&, double, double, const bool onlyCharged=false) const;
+    double getMiniIsoConeSize(const reco::RecoCandidate&, double, double, double) const;
 
     // In LeptonAnalyzerId.cc
     bool  passTriggerEmulationDoubleEG(const pat::Electron*, const bool hOverE = true) const;               //For ewkino id it needs to be possible to check hOverE separately
+    bool  passHOverEDoubleEG(const pat::Electron*) const;
     float slidingCut(float, float, float) const;
-    bool  passingElectronMvaHZZ(const pat::Electron*, double) const;
-    bool  passingElectronMvaLooseSusy(const pat::Electron*, double, double) const;
-    bool  passingElectronMvaMediumSusy(const pat::Electron*, double) const;
-    bool  passingElectronMvaTightSusy(const pat::Electron*, double) const;
-    bool  passingElectronMvaHeavyNeutrinoFO(const pat::Electron*, double) const;
-    bool  passElectronMvaEwkFO(const pat::Electron* ele, double mvaValue) const;
-
-    bool  isHNLoose(const pat::Electron& lepton) const;                                                     //check HNL id definitions
-    bool  isHNLoose(const pat::Muon& lepton) const;
-    bool  isHNFO(const pat::Electron& lepton) const;
-    bool  isHNFO(const pat::Muon& lepton) const;
-    bool  isHNTight(const pat::Electron& lepton) const;
-    bool  isHNTight(const pat::Muon& lepton) const;
-
-    bool isEwkLoose(const pat::Muon&) const;
-    bool isEwkLoose(const pat::Electron&) const;
+    bool  passingElectronMvaHZZ(double pt, double eta, double) const;
+    bool  passingElectronMvaLooseSusy(double pt, double eta, double, double) const;
+    bool  passingElectronMvaTightSusy(double pt, double eta, double) const;
+    bool  passingElectronMvaHeavyNeutrinoFO(double pt, double eta, double) const;
+    bool  passElectronMvaEwkFO(double pt, double eta, double mvaValue) const;
+
+    //HN and ewkino working points as cut tables, read per era from the leptonIds PSet (see python/leptonIds_cff.py)
+    enum LeptonId {hnLoose, hnFO, hnTight, ewkLoose, ewkFO, ewkTight, nLeptonIds};                          //FO requires loose and tight requires FO of the same family
+    enum ElectronMva {noElectronMva, electronMvaHNFO, electronMvaSUSYLoose, electronMvaSUSYTight, electronMvaEwkFO};
+    struct LeptonIdCuts {
+        double      minPt                    = std::numeric_limits<double>::lowest();                         //pass when value > min or value < max, cuts missing from the PSet are not applied
+        double      maxEta                   = std::numeric_limits<double>::max();
+        double      maxDxy                   = std::numeric_limits<double>::max();
+        double      maxDz                    = std::numeric_limits<double>::max();
+        double      max3dIPSig               = std::numeric_limits<double>::max();
+        double      maxRelIso                = std::numeric_limits<double>::max();
+        double      maxMiniIso               = std::numeric_limits<double>::max();
+        unsigned    maxMissingHits           = std::numeric_limits<unsigned>::max();                          //electrons only, pass when value <= max
+        bool        looseMuon                = false;
+        bool        mediumMuon               = false;
+        bool        convVeto                 = false;
+        bool        triggerEmulation         = false;                                                         //DoubleEG trigger emulation, with or without the H/E cut
+        bool        triggerEmulationNoHOverE = false;
+        bool        muonOverlap              = false;                                                         //electrons overlapping with a muon passing the same id fail
+        ElectronMva electronMva              = noElectronMva;
+        double      minLeptonMva             = std::numeric_limits<double>::lowest();                         //SUSY16 lepton MVA...
+        double      minPtRatio               = std::numeric_limits<double>::max();                            //...or the alternative on the closest jet, only when minPtRatio is given
+        double      maxClosestJetCsv         = std::numeric_limits<double>::max();
+        ElectronMva alternativeElectronMva   = noElectronMva;
+        double      hOverEConePt             = std::numeric_limits<double>::max();                            //H/E cut of the trigger emulation above this cone pt
+    };
+    LeptonIdCuts muonIdCuts[nLeptonIds];
+    LeptonIdCuts electronIdCuts[nLeptonIds];
+    bool*        leptonIdFlags[nLeptonIds];
+
+    LeptonIdCuts readLeptonIdCuts(const edm::ParameterSet&) const;
+    bool passElectronMva(const ElectronMva, const unsigned l) const;
+    bool passLeptonId(const LeptonIdCuts&, const unsigned id, const unsigned l, const bool electron, const unsigned overlaps) const;
+    void computeLeptonIds(const unsigned first, const unsigned n, const bool electrons);                     //all HN and ewkino ids for all muons or electrons at once
+
     bool isEwkLoose(const pat::Tau&) const;
-    bool isEwkFO(const pat::Muon&) const;
-    bool isEwkFO(const pat::Electron&) const;
-    bool isEwkFO(const pat::Tau&) const;
-    bool isEwkTight(const pat::Muon&) const;
-    bool isEwkTight(const pat::Electron&) const;
-    bool isEwkTight(const pat::Tau&) const;
-
-    double leptonMvaVal(const pat::Muon&, LeptonMvaHelper*);                                                            //compute ewkino lepton MVA
-    double leptonMvaVal(const pat::Electron&, LeptonMvaHelper*);
-
-    //for lepton MVA calculation
-    LeptonMvaHelper* leptonMvaComputerSUSY16;
-    LeptonMvaHelper* leptonMvaComputerTTH16;
-    LeptonMvaHelper* leptonMvaComputerSUSY17;
-    LeptonMvaHelper* leptonMvaComputerTTH17;
-    LeptonMvaHelper* leptonMvaComputertZqTTV16;
-    LeptonMvaHelper* leptonMvaComputertZqTTV17;
+    bool isEwkFO(const pat::Tau&, const unsigned) const;
+    bool isEwkTight(const pat::Tau&, const unsigned) const;
+
+    void fillLeptonMvaFeatures(const pat::Muon&);                                                            //collect the lepton MVA inputs
+    void fillLeptonMvaFeatures(const pat::Electron&);
+    void computeLeptonMvas(const LeptonMvaFeatures&, const unsigned first, const bool muons);                //all lepton MVAs for all muons or electrons at once
+
+    LeptonMvaFeatures muonMvaFeatures;
+    LeptonMvaFeatures electronMvaFeatures;
+
+    //for lepton MVA calculation: the trainings are booked in the global cache, only the ones listed in the leptonMvas parameter are stored
+    struct LeptonMva {
+        std::string                            name;                                                //as in the leptonMvas parameter, stored in _leptonMva<name>
+        double*                                values;
+        bool                                   stored;
+        std::shared_ptr<const LeptonMvaHelper> helper;                                              //shared by all streams, not set when the training is not booked
+    };
+    std::vector<LeptonMva> leptonMvas;
 
   public:
-    LeptonAnalyzer(const edm::ParameterSet& iConfig, multilep* vars);
-    ~LeptonAnalyzer();
+    LeptonAnalyzer(const edm::ParameterSet& iConfig, multilep* vars, const LeptonMvaHelpers&);
+    ~LeptonAnalyzer(){};
 
     void beginJob(TTree* outputTree);
-    bool analyze(const edm::Event&, const reco::Vertex&);
+    bool passSkim(const edm::Event&, const reco::Vertex&) const;                                        //only counts the preselected leptons
+    void analyze(const edm::Event&, const reco::Vertex&);
+    double leptonDeltaR2(const unsigned l1, const unsigned l2) const { return leptonDeltaR2s[l1][l2]; }   //for the cleaning of other objects against the stored leptons
 };
 #endif
@@ -0,0 +1,58 @@
+#ifndef LEPTON_MVA_FOREST_H
+#define LEPTON_MVA_FOREST_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Native evaluator for the gradient boosted decision trees (TMVA BDTG) used by the lepton MVAs
+ * The forest is read directly from the TMVA weight file, and every tree is stored as a complete binary tree of the maximum depth in flat arrays,
+ * such that all leptons of an event take the same number of branch-free steps through each tree
+ * The response is identical to TMVA::Reader::EvaluateMVA: float inputs and cuts, leaf responses summed in double and mapped to [-1, 1],
+ * and -999 when one of the inputs is NaN
+ * The flat arrays can be cached in a read-only binary file next to the weight file (<weightFile>.cache), written at install time by
+ * bin/makeLeptonMvaCache (see setup.sh): the cache is keyed by a hash of the xml content, which is verified when the cache is mapped,
+ * such that only the parsing of the xml is skipped; a missing cache is reported and falls back to parsing the xml, a stale cache throws
+ * (nothing is written at run time)
+ */
+class LeptonMvaForest {
+  public:
+    enum Source {cacheOrXml, xmlOnly};
+
+    LeptonMvaForest(const std::string& weightFile, const std::vector<std::string>& variableNames, const Source source = cacheOrXml); //variableNames: the expressions in the order of the weight file
+    LeptonMvaForest(const LeptonMvaForest&) = delete;
+    LeptonMvaForest& operator=(const LeptonMvaForest&) = delete;
+    ~LeptonMvaForest();
+
+    void evaluate(const float* features, const unsigned nLeptons, double* mvas) const;                  //features per variable: features[variable*nLeptons + lepton]
+    unsigned nVariables() const { return variableCount; }
+    bool     fromCache() const  { return mapping != nullptr; }
+
+    static std::vector<std::string> xmlVariableNames(const std::string& weightFile);                    //the expressions listed in the weight file
+    void writeCache() const;                                                                             //<weightFile>.cache for the current xml, throws on failure
+
+  private:
+    void readXml(const std::string& xml, const std::vector<std::string>& variableNames);
+    bool mapCache();
+    void setArrays(const char* body);
+
+    std::string                weightFile;
+    std::string                variableList;                                                             //expressions joined by newlines
+    uint64_t                   xmlHash;                                                                  //FNV-1a of the xml content, the key of the cache
+    uint64_t                   xmlSize;
+    unsigned                   variableCount;
+    unsigned                   depth;
+    unsigned                   nTrees;
+    unsigned                   nInternals;                                                               //internal nodes per tree, followed by nInternals+1 leaves
+
+    //flat arrays in the layout of the cache body, pointing either into the mapped cache or into storage
+    const int*                 nodeVariables;
+    const float*               nodeCuts;
+    const float*               leaves;
+    const unsigned char*       nodeCutTypes;                                                             //1: go right when value >= cut
+    std::vector<int>           storage;                                                                  //int for the alignment of the arrays
+    void*                      mapping = nullptr;
+    size_t                     mappingSize = 0;
+};
+#endif
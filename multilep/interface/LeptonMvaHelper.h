@@ -3,35 +3,60 @@
 #define Lepton_Mva_Helper
 
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "heavyNeutrino/multilep/interface/LeptonMvaForest.h"
 #include "TMVA/Reader.h"
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//Input features of all leptons of one flavour in an event, stored per feature and shared by all trainings
+//Features which are transformed differently by some of the trainings are stored in each of their forms
+class LeptonMvaFeatures{
+    public:
+        enum Feature {pt, eta, absEta, trackMult, miniIsoCharged, miniIsoNeutral, ptRel, ptRatio, ptRatioOrRelIso, csv, deepCsv, sip3d, logDxy, logDz, relIso0p3,
+                      segmentCompatibility, eleMvaSpring16GP, eleMvaSpring16HZZ, eleMvaFall17, nFeatures};
+
+        void clear(){ for(auto& column : columns) column.clear(); }
+        void add(double pt, double eta, double selectedTrackMult, double miniIsoCharged, double miniIsoNeutral, double ptRel, double ptRatio, double closestJetCsv, double closestJetDeepCsv,
+                 double sip3d, double dxy, double dz, double relIso0p3, double relIso0p4, double segComp, double eleMvaSpring16, double eleMvaHZZ, double eleMvaFall17);
+        unsigned size() const { return columns[0].size(); }
+        const float* column(const Feature feature) const { return columns[feature].data(); }
+    private:
+        std::vector<float> columns[nFeatures];
+};
+
 class LeptonMvaHelper{
     public:
         LeptonMvaHelper(const edm::ParameterSet& iConfig, const unsigned type, const bool sampleIs2017);
-        double leptonMvaMuon(double pt, double eta, double selectedTrackMult, double miniIsoCharged, double miniIsoNeutral, double ptRel, double ptRatio, double closestJetCsv, double closestJetDeepCsv, double sip3d, double dxy, double dz, double relIso0p3, double relIso0p4, double segComp);
-        double leptonMvaElectron(double pt, double eta, double selectedTrackMult, double miniIsoCharged, double miniIsoNeutral, double ptRel, double ptRatio, double closestJetCsv, double closesJetDeepCsv, double sip3d, double dxy, double dz, double relIso0p3, double relIso0p4, double eleMvaSpring16, double eleMvaHZZ, double eleMvaFall17);
+        ~LeptonMvaHelper();
+        void leptonMvaMuons(const LeptonMvaFeatures& features, double* mvas) const;                      //one value per lepton in the features
+        void leptonMvaElectrons(const LeptonMvaFeatures& features, double* mvas) const;
     private:
         unsigned type; //0 = SUSY , 1 = ttH , 2 = tZqttV
         bool is2017;
         bool is2018;
-        std::shared_ptr<TMVA::Reader> reader[2]; //First entry is for muons, second one for electrons
-        float LepGood_pt,                       //Variables used in MVA computation
-        LepGood_eta,
-        LepGood_jetNDauChargedMVASel,
-        LepGood_miniRelIsoCharged,
-        LepGood_miniRelIsoNeutral,
-        LepGood_jetPtRelv2,
-        LepGood_jetPtRatio,
-        LepGood_jetBTagCSV,
-        LepGood_sip3d,
-        LepGood_dxy,
-        LepGood_dz,
-        LepGood_segmentCompatibility,
-        LepGood_mvaIdSpring16GP,
-        LepGood_mvaIdFall17noIso,
-        LepGood_mvaIdSpring16HZZ,
-        LepGood_relIso0p3,
-        LepGood_relIso0p4;
-        void bookCommonVars(double pt, double eta, double selectedTrackMult, double miniIsoCharged, double miniIsoNeutral, double ptRel, double ptRatio, double closestJetCsv, double closestJetDeepCsv, double sip3d, double dxy, double dz, double relIso0p3, double relIso0p4); 
+        std::shared_ptr<const LeptonMvaForest> forest[2];                             //First entry is for muons, second one for electrons
+        std::vector<std::string> variableNames[2];                                    //Expressions as in the weight files
+        std::vector<LeptonMvaFeatures::Feature> variables[2];
+        void addVariable(const unsigned i, const std::string& expression, const LeptonMvaFeatures::Feature feature);
+        void bookMva(const unsigned i, const std::string& weightFile);
+        void evaluateMva(const unsigned i, const LeptonMvaFeatures& features, double* mvas) const;
+
+        //Optional cross-check (validateLeptonMvas): every evaluated lepton is also evaluated with TMVA::Reader on the same weight file and compared bitwise
+        //The readers are not thread-safe, so the check is serialised, the time spent in both evaluations is printed at the end of the job
+        bool validate;
+        std::string weightFiles[2];
+        std::unique_ptr<TMVA::Reader> reader[2];
+        mutable std::vector<float> readerInputs[2];
+        mutable std::mutex validationMutex;
+        mutable unsigned long nValidated[2] = {0, 0};
+        mutable double nativeTime[2]        = {0., 0.};                                                 //seconds
+        mutable double readerTime[2]        = {0., 0.};
+        void validateMva(const unsigned i, const float* matrix, const unsigned nLeptons, const double* mvas, const double evaluationTime) const;
 };
+
+//Trainings by name, booked once per job and shared by all streams
+typedef std::map<std::string, std::shared_ptr<const LeptonMvaHelper>> LeptonMvaHelpers;
 #endif
@@ -50,7 +50,7 @@ class LheAnalyzer {
     LheAnalyzer(const edm::ParameterSet& iConfig, multilep* vars);
     ~LheAnalyzer(){};
 
-    void beginJob(TTree* outputTree, edm::Service<TFileService>& fs);
+    void beginJob(TTree* outputTree, const OutputMerger& outputMerger);
     void analyze(const edm::Event&);
 };
 #endif
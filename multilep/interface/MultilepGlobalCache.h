@@ -0,0 +1,23 @@
+#ifndef MULTILEP_GLOBAL_CACHE_H
+#define MULTILEP_GLOBAL_CACHE_H
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "heavyNeutrino/multilep/interface/OutputMerger.h"
+#include "heavyNeutrino/multilep/interface/LeptonMvaHelper.h"
+
+#include "TDirectory.h"
+
+/*
+ * Job-wide state of the multilep stream module, created once and shared by all streams
+ * Next to the OutputMerger it holds the lepton MVA trainings listed in the leptonMvas parameter (and SUSY16, needed for the ewkino ids)
+ * These are never modified after booking and only evaluated through const calls, so the memory for the forests does not grow with the number of streams
+ */
+class MultilepGlobalCache {
+  public:
+    MultilepGlobalCache(const edm::ParameterSet&, TDirectory* directory);
+    ~MultilepGlobalCache(){};
+
+    OutputMerger     outputMerger;
+    LeptonMvaHelpers leptonMvaHelpers;                                                                  //booked trainings by name
+};
+#endif
@@ -0,0 +1,64 @@
+#ifndef OUTPUT_MERGER_H
+#define OUTPUT_MERGER_H
+#include "FWCore/Utilities/interface/StreamID.h"
+
+#include "TDirectory.h"
+#include "TTree.h"
+#include "TH1.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Global cache of the multilep stream module, collecting the output of all streams in the TFileService directory
+ * Every stream keeps its own branch buffers (bound to a stream-local tree which is never filled itself) and its own histograms
+ * Events are written to a single output tree through a serialised fill, which points the output branches to the buffers of the filling stream
+ * The stream histograms are added to the output histograms at the end of the job
+ */
+class OutputMerger {
+  public:
+    OutputMerger(TDirectory* directory);
+    ~OutputMerger(){};
+
+    void registerTree(const edm::StreamID, TTree* streamTree) const;                                     //the branches of the stream tree define the output tree
+    void fill(const edm::StreamID) const;
+    void merge() const;                                                                                  //to be called once all streams are done
+
+    template<typename T, typename... Args> T* make(const char* name, const Args&... args) const;       //returns a stream-local histogram, merged into the output at the end of the job
+
+  private:
+    struct MergedHistogram {
+      TH1*                              output;
+      std::vector<std::unique_ptr<TH1>> streams;
+    };
+
+    TDirectory*                                               directory;
+    mutable std::mutex                                        mutex;
+    mutable TTree*                                            outputTree = nullptr;
+    mutable std::vector<std::vector<std::pair<TBranch*, char*>>> streamAddresses;                      //for every stream: output branch and the address of the stream buffer
+    mutable unsigned                                          lastStream;                               //avoid rebinding the branches when the same stream fills twice in a row
+    mutable std::vector<MergedHistogram>                      histograms;
+};
+
+
+template<typename T, typename... Args> T* OutputMerger::make(const char* name, const Args&... args) const{
+    std::lock_guard<std::mutex> lock(mutex);
+    T* streamHistogram = new T(name, args...);
+    streamHistogram->SetDirectory(nullptr);
+
+    auto histogram = std::find_if(histograms.begin(), histograms.end(), [&](const MergedHistogram& h){ return std::string(h.output->GetName()) == name; });
+    if(histogram == histograms.end()){
+      TDirectory::TContext context(directory);
+      TH1* output = static_cast<TH1*>(streamHistogram->Clone());
+      output->SetDirectory(directory);
+      histograms.push_back({output, {}});
+      histogram = histograms.end() - 1;
+    }
+    histogram->streams.emplace_back(streamHistogram);
+    return streamHistogram;
+}
+#endif
@@ -0,0 +1,49 @@
+#ifndef PF_CANDIDATE_GRID_H
+#define PF_CANDIDATE_GRID_H
+#include "DataFormats/PatCandidates/interface/PackedCandidate.h"
+
+#include <vector>
+
+/*
+ * Per-event eta-phi grid over the packed PF candidates, used to restrict the cone loops (isolation, random cone isolation) to nearby candidates
+ * The kinematics and type information are unpacked once per event into flat arrays (structure of arrays), stored cell by cell (compressed row layout)
+ * A cone query streams through the cells overlapping the cone with a vectorised deltaR kernel, and returns the slots of the candidates
+ * which are (up to a small safety margin) inside the cone, sorted in the original order of the collection,
+ * such that a loop over them applying the usual deltaR cut gives exactly the same sums as a loop over the full collection
+ */
+class PFCandidateGrid {
+  public:
+    PFCandidateGrid();
+    ~PFCandidateGrid(){};
+
+    void fill(const std::vector<pat::PackedCandidate>&);
+    void candidatesInCone(const double eta, const double phi, const double radius, std::vector<unsigned>& slots) const;
+
+    // Cached values for a slot returned by candidatesInCone, identical to the PackedCandidate accessors
+    unsigned index(const unsigned slot) const  { return indices[slot]; }                                 //position in the original collection
+    double   eta(const unsigned slot) const    { return etas[slot]; }
+    double   phi(const unsigned slot) const    { return phis[slot]; }
+    double   pt(const unsigned slot) const     { return pts[slot]; }
+    int      absPdgId(const unsigned slot) const { return absPdgIds[slot]; }
+    int      charge(const unsigned slot) const { return charges[slot]; }
+    int      fromPV(const unsigned slot) const { return fromPVs[slot]; }
+
+  private:
+    static constexpr double   etaMax    = 5.;                                                            //candidates beyond are put in the outer cells
+    static constexpr unsigned nEtaCells = 50;
+    static constexpr unsigned nPhiCells = 32;
+    static constexpr double   margin    = 0.01;                                                          //safety margin on the cone radius, protects against rounding at the cell edges
+
+    int etaCell(const double eta) const;
+    int phiCell(const double phi) const;                                                                 //not wrapped, to be taken modulo nPhiCells
+
+    std::vector<unsigned> cellOffsets;                                                                   //start of each cell in the arrays below
+    std::vector<unsigned> indices;
+    std::vector<double>   etas;                                                                          //kept in double: the unpacked phi is not a float and the sums should not change
+    std::vector<double>   phis;
+    std::vector<double>   pts;
+    std::vector<int>      absPdgIds;
+    std::vector<int>      charges;
+    std::vector<int>      fromPVs;
+};
+#endif
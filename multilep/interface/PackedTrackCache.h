@@ -0,0 +1,47 @@
+#ifndef PACKED_TRACK_CACHE_H
+#define PACKED_TRACK_CACHE_H
+#include "DataFormats/PatCandidates/interface/PackedCandidate.h"
+#include "DataFormats/VertexReco/interface/Vertex.h"
+
+#include <vector>
+
+/*
+ * Per-event cache of the pseudo-track quantities of the packed PF candidates, indexed by the position (key) in the packed candidate collection
+ * A candidate is only unpacked the first time it is requested, afterwards the impact parameters to the primary vertex, hit counts and
+ * track quality are plain reads, shared by all analyzers (random cone isolation, selected track multiplicity of the jets, ...)
+ * Only to be used for candidates with track details
+ */
+class PackedTrackCache {
+  public:
+    struct Track {
+        double   pt;
+        double   px;
+        double   py;
+        double   pz;
+        double   p;
+        int      charge;
+        double   dxy;                                                                                    //to the primary vertex
+        double   dz;
+        unsigned numberOfValidHits;
+        unsigned numberOfValidPixelHits;
+        double   normalizedChi2;
+    };
+
+    PackedTrackCache(){};
+    ~PackedTrackCache(){};
+
+    void reset(const std::vector<pat::PackedCandidate>&, const reco::Vertex&);
+    const Track& track(const unsigned key);
+    const Track& track(const pat::PackedCandidate&);                                                      //e.g. jet daughters, candidates outside the collection are not cached
+
+  private:
+    void unpack(const pat::PackedCandidate&, Track&) const;
+
+    const pat::PackedCandidate* candidates = nullptr;
+    unsigned                    nCandidates = 0;
+    reco::Vertex::Point         vertexPosition;
+    std::vector<bool>           unpacked;
+    std::vector<Track>          tracks;
+    Track                       uncached;
+};
+#endif
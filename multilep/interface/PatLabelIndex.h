@@ -0,0 +1,39 @@
+#ifndef PAT_LABEL_INDEX_H
+#define PAT_LABEL_INDEX_H
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Positions of a fixed list of labels in the label-value pairs of PAT objects (electronIDs(), photonIDs(), tauIDs(), getPairDiscri()),
+ * such that the IDs and discriminators are read by index instead of a string comparison over all labels for every object and every label
+ * validate() is called on the first object of the collection in every event: the positions are only resolved again when the layout changed
+ * (e.g. a new input file); value() still checks for every object that the label at the stored position is the requested one (a single
+ * string comparison instead of a scan over all labels), objects with a different layout and labels missing from the layout fall back to the PAT lookup
+ * bin/benchmarkPatLabelIndex compares the time per lookup with the PAT lookup
+ */
+class PatLabelIndex {
+  public:
+    typedef std::vector<std::pair<std::string, float>> LabelValues;
+    enum Lookup {firstOrThrow, lastOrDefault};                                                          //electronID, photonID, tauID: first match, exception when missing; bDiscriminator: last match, -1000 when missing
+
+    PatLabelIndex(const std::vector<std::string>& labels, const Lookup lookup = firstOrThrow);
+    ~PatLabelIndex(){};
+
+    void  validate(const LabelValues&);
+    float value(const LabelValues& pairs, const unsigned label) const{
+        const int i = indices[label];
+        if(i >= 0 and (size_t) i < pairs.size() and pairs[i].first == labels[label]) return pairs[i].second;
+        return find(pairs, label);
+    }
+
+  private:
+    int   position(const LabelValues&, const unsigned label) const;
+    float find(const LabelValues&, const unsigned label) const;
+
+    std::vector<std::string> labels;
+    Lookup                   lookup;
+    std::vector<int>         indices;                                                                     //-1 when missing from the layout
+    size_t                   layoutSize = 0;
+};
+#endif
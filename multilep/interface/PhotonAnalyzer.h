@@ -7,6 +7,7 @@
 #include "RecoEgamma/EgammaTools/interface/EffectiveAreas.h"
 
 #include "heavyNeutrino/multilep/plugins/multilep.h"
+#include "heavyNeutrino/multilep/interface/PatLabelIndex.h"
 
 #include "TTree.h"
 #include <TRandom3.h>
@@ -18,6 +19,7 @@ class PhotonAnalyzer {
         EffectiveAreas chargedEffectiveAreas;
         EffectiveAreas neutralEffectiveAreas;
         EffectiveAreas photonsEffectiveAreas;
+        PatLabelIndex  photonIds;                                                                        //positions of the cut based IDs, see PhotonAnalyzer.cc for the labels
 
         static const unsigned nPhoton_max = 20;
 
@@ -55,8 +57,9 @@ class PhotonAnalyzer {
         double   _phTTGMatchEta[nPhoton_max];
         int      _phMatchPdgId[nPhoton_max];
 
+        bool isPreselected(const pat::Photon&) const;                                                  //object preselection, shared by skim and fill phase
         void fillPhotonGenVars(const reco::GenParticle*);
-        double randomConeIso(double, edm::Handle<std::vector<pat::PackedCandidate>>&, const reco::Vertex&,
+        double randomConeIso(double, edm::Handle<std::vector<pat::PackedCandidate>>&,
                 edm::Handle<std::vector<pat::Electron>>&, edm::Handle<std::vector<pat::Muon>>&,
                 edm::Handle<std::vector<pat::Jet>>&, edm::Handle<std::vector<pat::Photon>>&);
         void matchCategory(const pat::Photon&, edm::Handle<std::vector<reco::GenParticle>>&);
@@ -69,6 +72,7 @@ class PhotonAnalyzer {
         ~PhotonAnalyzer(){};
 
         void beginJob(TTree* outputTree);
-        bool analyze(const edm::Event&);
+        bool passSkim(const edm::Event&) const;                                                        //only counts the preselected photons
+        void analyze(const edm::Event&);
 };
 #endif
@@ -22,7 +22,7 @@ class SUSYMassAnalyzer{
     public:
         SUSYMassAnalyzer(const edm::ParameterSet&, multilep*, LheAnalyzer*);
         ~SUSYMassAnalyzer(){};
-        void beginJob(TTree* outputTree, edm::Service<TFileService>&);
+        void beginJob(TTree* outputTree, const OutputMerger&);
         void beginLuminosityBlock(const edm::LuminosityBlock&, const edm::EventSetup&);
         void analyze(const edm::Event&);
 };
@@ -0,0 +1,93 @@
+#include "heavyNeutrino/multilep/plugins/jetSmearingProducer.h"
+#include "DataFormats/Math/interface/deltaR.h"
+
+#include <cmath>
+#include <limits>
+
+const std::string jetSmearingProducer::instanceNames[nSmearings] = {"pt", "ptDown", "ptUp"};
+const Variation   jetSmearingProducer::jerVariations[nSmearings] = {Variation::NOMINAL, Variation::DOWN, Variation::UP};
+
+jetSmearingProducer::jetSmearingProducer(const edm::ParameterSet& iConfig):
+    jetToken(                         consumes<std::vector<pat::Jet>>(            iConfig.getParameter<edm::InputTag>("src"))),
+    genJetToken(                      consumes<std::vector<reco::GenJet>>(        iConfig.getParameter<edm::InputTag>("genJets"))),
+    rhoToken(                         consumes<double>(                           iConfig.getParameter<edm::InputTag>("rho"))),
+    algo(                                                                         iConfig.getParameter<std::string>("algo")),
+    algoPt(                                                                       iConfig.getParameter<std::string>("algopt")),
+    dRMax(                                                                        iConfig.getParameter<double>("dRMax")),
+    dPtMaxFactor(                                                                 iConfig.getParameter<double>("dPtMaxFactor"))
+{
+    for(auto& engine : randomEngines) engine.seed(iConfig.getParameter<unsigned>("seed"));
+    for(auto& name : instanceNames)   produces<edm::ValueMap<double>>(name);
+}
+
+// ------------ same genJet matching as pat::GenJetMatcher: closest genJet within dRMax and with |dPt| < dPtMaxFactor*resolution  ------------
+const reco::GenJet* jetSmearingProducer::matchGenJet(const pat::Jet& jet, const std::vector<reco::GenJet>& genJets, const double resolution) const{
+    double minDeltaR = std::numeric_limits<double>::infinity();
+    const reco::GenJet* match = nullptr;
+    for(const auto& genJet : genJets){
+        double dR = reco::deltaR(genJet, jet);
+        if(dR > minDeltaR) continue;
+        if(dR < dRMax){
+            if(std::abs(genJet.pt() - jet.pt()) > dPtMaxFactor*resolution) continue;
+            minDeltaR = dR;
+            match     = &genJet;
+        }
+    }
+    return match;
+}
+
+// ------------ smeared pt for the three variations, the resolution and genJet match are shared  ------------
+void jetSmearingProducer::produce(edm::Event& iEvent, const edm::EventSetup& iSetup){
+    edm::Handle<std::vector<pat::Jet>> jets;       iEvent.getByToken(jetToken, jets);
+
+    std::vector<double> smearedPt[nSmearings];
+    for(auto& pts : smearedPt) pts.reserve(jets->size());
+
+    if(iEvent.isRealData()){                                                                          //no smearing on data, simply pass the jet pt
+        for(const auto& jet : *jets){
+            for(auto& pts : smearedPt) pts.push_back(jet.pt());
+        }
+    } else {
+        edm::Handle<std::vector<reco::GenJet>> genJets; iEvent.getByToken(genJetToken, genJets);
+        edm::Handle<double> rho;                        iEvent.getByToken(rhoToken,    rho);
+
+        JME::JetResolution resolution                 = JME::JetResolution::get(iSetup, algoPt);
+        JME::JetResolutionScaleFactor resolutionSF    = JME::JetResolutionScaleFactor::get(iSetup, algo);
+
+        static const double minJetEnergy = 1e-2;                                                      //as in SmearedPATJetProducer, avoids flipping the jet direction
+        for(const auto& jet : *jets){
+            if(jet.pt() == 0){
+                for(auto& pts : smearedPt) pts.push_back(jet.pt());
+                continue;
+            }
+
+            double jetResolution = resolution.getResolution({{JME::Binning::JetPt, jet.pt()}, {JME::Binning::JetEta, jet.eta()}, {JME::Binning::Rho, *rho}});
+            const reco::GenJet* genJet = matchGenJet(jet, *genJets, jet.pt()*jetResolution);
+
+            for(unsigned s = 0; s < nSmearings; ++s){
+                double jerSF = resolutionSF.getScaleFactor({{JME::Binning::JetPt, jet.pt()}, {JME::Binning::JetEta, jet.eta()}}, jerVariations[s]);
+
+                double smearFactor = 1.;
+                if(genJet){                                                                           //scaling with the matched genJet
+                    smearFactor = 1. + (jerSF - 1.)*(jet.pt() - genJet->pt())/jet.pt();
+                } else if(jerSF > 1){                                                                 //stochastic smearing
+                    std::normal_distribution<> gauss(0, jetResolution*std::sqrt(jerSF*jerSF - 1));
+                    smearFactor = 1. + gauss(randomEngines[s]);
+                }
+                if(jet.energy()*smearFactor < minJetEnergy) smearFactor = minJetEnergy/jet.energy();
+                smearedPt[s].push_back(jet.pt()*smearFactor);
+            }
+        }
+    }
+
+    for(unsigned s = 0; s < nSmearings; ++s){
+        auto valueMap = std::make_unique<edm::ValueMap<double>>();
+        edm::ValueMap<double>::Filler filler(*valueMap);
+        filler.insert(jets, smearedPt[s].begin(), smearedPt[s].end());
+        filler.fill();
+        iEvent.put(std::move(valueMap), instanceNames[s]);
+    }
+}
+
+//define this as a plug-in
+DEFINE_FWK_MODULE(jetSmearingProducer);
@@ -0,0 +1,50 @@
+#ifndef JET_SMEARING_PRODUCER_H
+#define JET_SMEARING_PRODUCER_H
+
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "FWCore/Framework/interface/stream/EDProducer.h"
+
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "DataFormats/Common/interface/ValueMap.h"
+#include "DataFormats/JetReco/interface/GenJet.h"
+#include "DataFormats/PatCandidates/interface/Jet.h"
+#include "JetMETCorrections/Modules/interface/JetResolution.h"
+
+#include <random>
+
+/*
+ * Jet energy resolution smearing for the nominal, down and up variations in a single pass
+ * Follows the hybrid method of SmearedPATJetProducer (https://twiki.cern.ch/twiki/bin/view/CMS/JetResolution#Smearing_procedures):
+ * the genJet matching is done only once per jet, as it does not depend on the variation, and only the smeared pt is stored,
+ * as ValueMaps keyed to the input jets, such that the multilep module can read them by jet index
+ * Each variation keeps its own random engine with the same seed, so the stochastic smearing draws the same numbers as three separate producers would
+ */
+class jetSmearingProducer : public edm::stream::EDProducer<> {
+    public:
+        explicit jetSmearingProducer(const edm::ParameterSet&);
+        ~jetSmearingProducer(){};
+
+    private:
+        enum Smearing {nominal, down, up, nSmearings};                                                 //same order as the JME Variation enum
+
+        edm::EDGetTokenT<std::vector<pat::Jet>>     jetToken;
+        edm::EDGetTokenT<std::vector<reco::GenJet>> genJetToken;
+        edm::EDGetTokenT<double>                    rhoToken;
+        std::string                                 algo;
+        std::string                                 algoPt;
+        double                                      dRMax;
+        double                                      dPtMaxFactor;
+        std::mt19937                                randomEngines[nSmearings];
+
+        static const std::string                    instanceNames[nSmearings];
+        static const Variation                      jerVariations[nSmearings];
+
+        virtual void produce(edm::Event&, const edm::EventSetup&) override;
+
+        const reco::GenJet* matchGenJet(const pat::Jet&, const std::vector<reco::GenJet>&, const double resolution) const;
+};
+#endif
@@ -1,43 +1,48 @@
 #include "heavyNeutrino/multilep/plugins/multilep.h"
 
 
-multilep::multilep(const edm::ParameterSet& iConfig):
+multilep::multilep(const edm::ParameterSet& iConfig, const MultilepGlobalCache* cache):
     vtxToken(                         consumes<std::vector<reco::Vertex>>(        iConfig.getParameter<edm::InputTag>("vertices"))),
     genEventInfoToken(                consumes<GenEventInfoProduct>(              iConfig.getParameter<edm::InputTag>("genEventInfo"))),
     genLumiInfoToken(                 consumes<GenLumiInfoHeader, edm::InLumi>(   iConfig.getParameter<edm::InputTag>("genEventInfo"))),
     lheEventInfoToken(                consumes<LHEEventProduct>(                  iConfig.getParameter<edm::InputTag>("lheEventInfo"))),
     pileUpToken(                      consumes<std::vector<PileupSummaryInfo>>(   iConfig.getParameter<edm::InputTag>("pileUpInfo"))),
-    genParticleToken(                 consumes<reco::GenParticleCollection>(      iConfig.getParameter<edm::InputTag>("genParticles"))),
-    muonToken(                        consumes<std::vector<pat::Muon>>(           iConfig.getParameter<edm::InputTag>("muons"))),
-    eleToken(                         consumes<std::vector<pat::Electron>>(       iConfig.getParameter<edm::InputTag>("electrons"))),
-    tauToken(                         consumes<std::vector<pat::Tau>>(            iConfig.getParameter<edm::InputTag>("taus"))),
-    photonToken(                      consumes<std::vector<pat::Photon>>(         iConfig.getParameter<edm::InputTag>("photons"))),
-    packedCandidatesToken(            consumes<std::vector<pat::PackedCandidate>>(iConfig.getParameter<edm::InputTag>("packedCandidates"))),
-    rhoToken(                         consumes<double>(                           iConfig.getParameter<edm::InputTag>("rho"))),
-    metToken(                         consumes<std::vector<pat::MET>>(            iConfig.getParameter<edm::InputTag>("met"))),
-    jetToken(                         consumes<std::vector<pat::Jet>>(            iConfig.getParameter<edm::InputTag>("jets"))),
-    jetSmearedToken(                  consumes<std::vector<pat::Jet>>(            iConfig.getParameter<edm::InputTag>("jetsSmeared"))),
-    jetSmearedUpToken(                consumes<std::vector<pat::Jet>>(            iConfig.getParameter<edm::InputTag>("jetsSmearedUp"))),
-    jetSmearedDownToken(              consumes<std::vector<pat::Jet>>(            iConfig.getParameter<edm::InputTag>("jetsSmearedDown"))),
-    recoResultsPrimaryToken(          consumes<edm::TriggerResults>(              iConfig.getParameter<edm::InputTag>("recoResultsPrimary"))),
-    recoResultsSecondaryToken(        consumes<edm::TriggerResults>(              iConfig.getParameter<edm::InputTag>("recoResultsSecondary"))),
-    triggerToken(                     consumes<edm::TriggerResults>(              iConfig.getParameter<edm::InputTag>("triggers"))),
-    prescalesToken(                   consumes<pat::PackedTriggerPrescales>(      iConfig.getParameter<edm::InputTag>("prescales"))),
     skim(                                                                         iConfig.getUntrackedParameter<std::string>("skim")),
     isData(                                                                       iConfig.getUntrackedParameter<bool>("isData")),
     is2017(                                                                       iConfig.getUntrackedParameter<bool>("is2017")),
     is2018(                                                                       iConfig.getUntrackedParameter<bool>("is2018")),
     isSUSY(                                                                       iConfig.getUntrackedParameter<bool>("isSUSY")),
-    storeLheParticles(                                                            iConfig.getUntrackedParameter<bool>("storeLheParticles"))
+    storeLheParticles(                                                            iConfig.getUntrackedParameter<bool>("storeLheParticles")),
+    countersOnly(                                                                 iConfig.getUntrackedParameter<bool>("countersOnly", false))
 {
+    lheAnalyzer     = new LheAnalyzer(iConfig, this);
+    susyMassAnalyzer= new SUSYMassAnalyzer(iConfig, this, lheAnalyzer);
+    outputTree      = nullptr;
+    if(countersOnly) return;                                           // the counter instance must not consume the products of the egamma, jet and MET sequences
+
+    genParticleToken          = consumes<reco::GenParticleCollection>(      iConfig.getParameter<edm::InputTag>("genParticles"));
+    muonToken                 = consumes<std::vector<pat::Muon>>(           iConfig.getParameter<edm::InputTag>("muons"));
+    eleToken                  = consumes<std::vector<pat::Electron>>(       iConfig.getParameter<edm::InputTag>("electrons"));
+    tauToken                  = consumes<std::vector<pat::Tau>>(            iConfig.getParameter<edm::InputTag>("taus"));
+    photonToken               = consumes<std::vector<pat::Photon>>(         iConfig.getParameter<edm::InputTag>("photons"));
+    packedCandidatesToken     = consumes<std::vector<pat::PackedCandidate>>(iConfig.getParameter<edm::InputTag>("packedCandidates"));
+    rhoToken                  = consumes<double>(                           iConfig.getParameter<edm::InputTag>("rho"));
+    metToken                  = consumes<std::vector<pat::MET>>(            iConfig.getParameter<edm::InputTag>("met"));
+    jetToken                  = consumes<std::vector<pat::Jet>>(            iConfig.getParameter<edm::InputTag>("jets"));
+    jetSmearedPtToken         = consumes<edm::ValueMap<double>>(            iConfig.getParameter<edm::InputTag>("jetsSmearedPt"));
+    jetSmearedPtUpToken       = consumes<edm::ValueMap<double>>(            iConfig.getParameter<edm::InputTag>("jetsSmearedPtUp"));
+    jetSmearedPtDownToken     = consumes<edm::ValueMap<double>>(            iConfig.getParameter<edm::InputTag>("jetsSmearedPtDown"));
+    recoResultsPrimaryToken   = consumes<edm::TriggerResults>(              iConfig.getParameter<edm::InputTag>("recoResultsPrimary"));
+    recoResultsSecondaryToken = consumes<edm::TriggerResults>(              iConfig.getParameter<edm::InputTag>("recoResultsSecondary"));
+    triggerToken              = consumes<edm::TriggerResults>(              iConfig.getParameter<edm::InputTag>("triggers"));
+    prescalesToken            = consumes<pat::PackedTriggerPrescales>(      iConfig.getParameter<edm::InputTag>("prescales"));
     if(is2017 or is2018) ecalBadCalibFilterToken = consumes<bool>(edm::InputTag("ecalBadCalibReducedMINIAODFilter"));
+
     triggerAnalyzer = new TriggerAnalyzer(iConfig, this);
-    leptonAnalyzer  = new LeptonAnalyzer(iConfig, this);
+    leptonAnalyzer  = new LeptonAnalyzer(iConfig, this, cache->leptonMvaHelpers);
     photonAnalyzer  = new PhotonAnalyzer(iConfig, this);
     jetAnalyzer     = new JetAnalyzer(iConfig, this);
     genAnalyzer     = new GenAnalyzer(iConfig, this);
-    lheAnalyzer     = new LheAnalyzer(iConfig, this);
-    susyMassAnalyzer= new SUSYMassAnalyzer(iConfig, this, lheAnalyzer);
 }
 
 multilep::~multilep(){
@@ -48,14 +53,40 @@ multilep::~multilep(){
     delete genAnalyzer;
     delete lheAnalyzer;
     delete susyMassAnalyzer;
+    delete outputTree;
 }
 
-// ------------ method called once each job just before starting event loop  ------------
-void multilep::beginJob(){
+// ------------ method called once each job, the output tree and histograms are booked in the TFileService directory of this module, and the lepton MVAs are read ------------
+// ------------ the counter instance books its histograms in the directory of the ntuplizer instead (counterDirectory), next to the tree ------------
+std::unique_ptr<MultilepGlobalCache> multilep::initializeGlobalCache(const edm::ParameterSet& iConfig){
+    edm::Service<TFileService> fs;
+    if(!iConfig.getUntrackedParameter<bool>("countersOnly", false)) return std::make_unique<MultilepGlobalCache>(iConfig, fs->getBareDirectory());
 
-    //Initialize tree with event info
-    outputTree = fs->make<TTree>("blackJackAndHookersTree", "blackJackAndHookersTree");
-    nVertices  = fs->make<TH1D>("nVertices", "Number of vertices", 120, 0, 120);
+    const std::string directoryName = iConfig.getUntrackedParameter<std::string>("counterDirectory");
+    TDirectory* directory           = fs->file().GetDirectory(directoryName.c_str());
+    if(!directory) directory        = fs->file().mkdir(directoryName.c_str());
+    return std::make_unique<MultilepGlobalCache>(iConfig, directory);
+}
+
+// ------------ method called once each job after all streams are done, adds up the histograms of the streams ------------
+void multilep::globalEndJob(const MultilepGlobalCache* cache){
+    cache->outputMerger.merge();
+}
+
+// ------------ method called once for each stream just before starting event loop  ------------
+void multilep::beginStream(edm::StreamID streamID){
+
+    //The counter instance only books the event counters, which are filled for every event
+    if(countersOnly){
+        nVertices = globalCache()->outputMerger.make<TH1D>("nVertices", "Number of vertices", 120, 0, 120);
+        if(!isData) lheAnalyzer->beginJob(nullptr, globalCache()->outputMerger);
+        if(isSUSY)  susyMassAnalyzer->beginJob(nullptr, globalCache()->outputMerger);
+        return;
+    }
+
+    //Initialize tree with event info, the tree itself is never filled or written, it only defines the branches of the output tree
+    outputTree = new TTree("blackJackAndHookersTree", "blackJackAndHookersTree");
+    outputTree->SetDirectory(nullptr);
 
     //Set all branches of the outputTree
     outputTree->Branch("_runNb",                        &_runNb,                        "_runNb/l");
@@ -63,14 +94,16 @@ void multilep::beginJob(){
     outputTree->Branch("_eventNb",                      &_eventNb,                      "_eventNb/l");
     outputTree->Branch("_nVertex",                      &_nVertex,                      "_nVertex/b");
 
-    if(!isData) lheAnalyzer->beginJob(outputTree, fs);
-    if(isSUSY)  susyMassAnalyzer->beginJob(outputTree, fs);
+    if(!isData) lheAnalyzer->beginJob(outputTree, globalCache()->outputMerger);
+    if(isSUSY)  susyMassAnalyzer->beginJob(outputTree, globalCache()->outputMerger);
     if(!isData) genAnalyzer->beginJob(outputTree);
     triggerAnalyzer->beginJob(outputTree);
     leptonAnalyzer->beginJob(outputTree);
     photonAnalyzer->beginJob(outputTree);
     jetAnalyzer->beginJob(outputTree);
 
+    globalCache()->outputMerger.registerTree(streamID, outputTree);
+
     _runNb = 0;
 }
 
@@ -83,28 +116,50 @@ void multilep::beginLuminosityBlock(const edm::LuminosityBlock& iLumi, const edm
 //------------- method called for each run -------------
 void multilep::beginRun(const edm::Run& iRun, edm::EventSetup const& iSetup){
     _runNb = (unsigned long) iRun.id().run();
-    triggerAnalyzer->reIndex = true;                                   // HLT results could have different size/order in new run, so look up again the index positions
+    if(!countersOnly) triggerAnalyzer->reIndex = true;                 // HLT results could have different size/order in new run, so look up again the index positions
 }
 
 // ------------ method called for each event  ------------
 void multilep::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup){
     edm::Handle<std::vector<reco::Vertex>> vertices; iEvent.getByToken(vtxToken, vertices);
     if(!isData) lheAnalyzer->analyze(iEvent);                          // needs to be run before selection to get correct uncertainties on MC xsection
-    if(isSUSY) susyMassAnalyzer->analyze(iEvent);                      // needs to be run after LheAnalyzer, but before all other models
 
     //extract number of vertices 
     _nVertex = vertices->size();
-    nVertices->Fill(_nVertex, lheAnalyzer->getWeight()); 
+
+    //The counter instance (in the EndPath) sees all events, the ntuplizer only runs for events passing the upstream skim filter
+    if(countersOnly){
+        if(isSUSY) susyMassAnalyzer->analyze(iEvent);                  // needs to be run after LheAnalyzer
+        nVertices->Fill(_nVertex, lheAnalyzer->getWeight());
+        return;
+    }
     if(_nVertex == 0) return;                                          //Don't consider 0 vertex events
 
-    if(!leptonAnalyzer->analyze(iEvent, *(vertices->begin()))) return; // returns false if doesn't pass skim condition, so skip event in such case
-    if(!photonAnalyzer->analyze(iEvent))                       return;
-    if(!jetAnalyzer->analyze(iEvent))                          return;
+    //Selection phase: only count preselected objects, skip the event if it doesn't pass the skim condition
+    if(!leptonAnalyzer->passSkim(iEvent, *(vertices->begin())))  return;
+    if(!photonAnalyzer->passSkim(iEvent))                        return;
+    if(!jetAnalyzer->analyze(iEvent))                            return; // jet skims depend on the JEC/JER variations, jets are filled directly
+
+    //Fill phase: all expensive per-object variables, only for events passing the skim
+    edm::Handle<std::vector<pat::PackedCandidate>> packedCands; iEvent.getByToken(packedCandidatesToken, packedCands);
+    pfCandidateGrid.fill(*packedCands);
+    packedTrackCache.reset(*packedCands, *(vertices->begin()));
+    edm::Handle<std::vector<pat::Jet>> jets;                    iEvent.getByToken(jetToken, jets);   // Are we sure we do not want the smeared jets for the lepton variables???
+    jetView.fill(*jets, packedTrackCache);
+    if(!isData){
+        edm::Handle<std::vector<reco::GenParticle>> genParticles; iEvent.getByToken(genParticleToken, genParticles);
+        if(genParticles.isValid()){
+            genAncestry.fill(*genParticles);
+            genEventView.fill(*genParticles);
+        }
+    }
+    leptonAnalyzer->analyze(iEvent, *(vertices->begin()));
+    photonAnalyzer->analyze(iEvent);
     if(!isData) genAnalyzer->analyze(iEvent);
     triggerAnalyzer->analyze(iEvent);
 
     _eventNb   = (unsigned long) iEvent.id().event();                  //determine event number run number and luminosity block
-    outputTree->Fill();                                                //store calculated event info in root tree
+    globalCache()->outputMerger.fill(iEvent.streamID());               //store calculated event info in root tree
 }
 
 //define this as a plug-in
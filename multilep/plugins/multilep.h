@@ -2,7 +2,7 @@
 #define MULTILEP_H
 
 #include "FWCore/Framework/interface/Frameworkfwd.h"
-#include "FWCore/Framework/interface/one/EDAnalyzer.h"
+#include "FWCore/Framework/interface/stream/EDAnalyzer.h"
 
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/LuminosityBlock.h"
@@ -20,6 +20,7 @@
 #include "DataFormats/PatCandidates/interface/Jet.h"
 #include "DataFormats/VertexReco/interface/Vertex.h"
 #include "DataFormats/Common/interface/TriggerResults.h"
+#include "DataFormats/Common/interface/ValueMap.h"
 #include "DataFormats/PatCandidates/interface/PackedTriggerPrescales.h"
 #include "SimDataFormats/GeneratorProducts/interface/GenEventInfoProduct.h"
 #include "SimDataFormats/GeneratorProducts/interface/LHEEventProduct.h"
@@ -32,6 +33,12 @@
 #include "FWCore/ServiceRegistry/interface/Service.h"
 #include "CommonTools/UtilAlgos/interface/TFileService.h"
 
+#include "heavyNeutrino/multilep/interface/MultilepGlobalCache.h"
+#include "heavyNeutrino/multilep/interface/PFCandidateGrid.h"
+#include "heavyNeutrino/multilep/interface/PackedTrackCache.h"
+#include "heavyNeutrino/multilep/interface/JetView.h"
+#include "heavyNeutrino/multilep/interface/GenAncestry.h"
+#include "heavyNeutrino/multilep/interface/GenEventView.h"
 #include "heavyNeutrino/multilep/interface/TriggerAnalyzer.h"
 #include "heavyNeutrino/multilep/interface/LeptonAnalyzer.h"
 #include "heavyNeutrino/multilep/interface/PhotonAnalyzer.h"
@@ -51,7 +58,9 @@ class GenAnalyzer;
 class LheAnalyzer;
 class SUSYMassAnalyzer;
 
-class multilep : public edm::one::EDAnalyzer<edm::one::WatchLuminosityBlocks, edm::one::WatchRuns, edm::one::SharedResources> {
+//Stream module: every stream has its own sub-analyzers and branch buffers, the OutputMerger serialises the filling of the output tree
+//The global cache also holds the lepton MVA trainings, shared by all streams
+class multilep : public edm::stream::EDAnalyzer<edm::GlobalCache<MultilepGlobalCache>> {
     //Define other analyzers as friends
     friend TriggerAnalyzer;
     friend LeptonAnalyzer;
@@ -61,9 +70,12 @@ class multilep : public edm::one::EDAnalyzer<edm::one::WatchLuminosityBlocks, ed
     friend LheAnalyzer;
     friend SUSYMassAnalyzer;
     public:
-        explicit multilep(const edm::ParameterSet&);
+        explicit multilep(const edm::ParameterSet&, const MultilepGlobalCache*);
         ~multilep();
 
+        static std::unique_ptr<MultilepGlobalCache> initializeGlobalCache(const edm::ParameterSet&);
+        static void globalEndJob(const MultilepGlobalCache*);
+
     private:
         edm::EDGetTokenT<std::vector<reco::Vertex>>         vtxToken;
         edm::EDGetTokenT<GenEventInfoProduct>               genEventInfoToken;
@@ -79,9 +91,9 @@ class multilep : public edm::one::EDAnalyzer<edm::one::WatchLuminosityBlocks, ed
         edm::EDGetTokenT<double>                            rhoToken;
         edm::EDGetTokenT<std::vector<pat::MET>>             metToken;
         edm::EDGetTokenT<std::vector<pat::Jet>>             jetToken;
-        edm::EDGetTokenT<std::vector<pat::Jet>>             jetSmearedToken;
-        edm::EDGetTokenT<std::vector<pat::Jet>>             jetSmearedUpToken;
-        edm::EDGetTokenT<std::vector<pat::Jet>>             jetSmearedDownToken;
+        edm::EDGetTokenT<edm::ValueMap<double>>             jetSmearedPtToken;                           //smeared pt from the jetSmearingProducer, keyed to the jets
+        edm::EDGetTokenT<edm::ValueMap<double>>             jetSmearedPtUpToken;
+        edm::EDGetTokenT<edm::ValueMap<double>>             jetSmearedPtDownToken;
         edm::EDGetTokenT<edm::TriggerResults>               recoResultsPrimaryToken;                     //MET filter information
         edm::EDGetTokenT<edm::TriggerResults>               recoResultsSecondaryToken;                   //MET filter information (fallback if primary is not available)
         edm::EDGetTokenT<edm::TriggerResults>               triggerToken;
@@ -93,26 +105,28 @@ class multilep : public edm::one::EDAnalyzer<edm::one::WatchLuminosityBlocks, ed
         bool                                                is2018;
         bool                                                isSUSY;
         bool                                                storeLheParticles;
+        bool                                                countersOnly;                                //instance in the EndPath which only fills the event counters (hCounter, lheCounter, nVertices,...)
 
-        virtual void beginJob() override;
+        virtual void beginStream(edm::StreamID) override;
         virtual void beginLuminosityBlock(const edm::LuminosityBlock&, const edm::EventSetup&) override;
         virtual void beginRun(const edm::Run&, edm::EventSetup const&) override;
         virtual void analyze(const edm::Event&, const edm::EventSetup&) override;
 
-        virtual void endRun(const edm::Run&, edm::EventSetup const&) override {}                         //Unused functions
-        virtual void endLuminosityBlock(const edm::LuminosityBlock&, const edm::EventSetup&) override {}
-        virtual void endJob() override {};
-
-        TriggerAnalyzer*  triggerAnalyzer;
-        LeptonAnalyzer*   leptonAnalyzer;
-        PhotonAnalyzer*   photonAnalyzer;
-        JetAnalyzer*      jetAnalyzer;
+        TriggerAnalyzer*  triggerAnalyzer = nullptr;                                                     //only created for the ntuplizer, not for the counter instance
+        LeptonAnalyzer*   leptonAnalyzer  = nullptr;
+        PhotonAnalyzer*   photonAnalyzer  = nullptr;
+        JetAnalyzer*      jetAnalyzer     = nullptr;
         LheAnalyzer*      lheAnalyzer;
-        GenAnalyzer*      genAnalyzer;
+        GenAnalyzer*      genAnalyzer     = nullptr;
         SUSYMassAnalyzer* susyMassAnalyzer;
 
-        edm::Service<TFileService> fs;                                                                   //Root tree and file for storing event info
-        TTree* outputTree;
+        PFCandidateGrid  pfCandidateGrid;                                                                //Per-event eta-phi index of the packed PF candidates, used for all cone loops
+        PackedTrackCache packedTrackCache;                                                               //Per-event pseudo-track quantities of the packed PF candidates, unpacked on first use
+        JetView          jetView;                                                                        //Per-event view of the jets close to leptons, with the lepton-jet deltaR matrix
+        GenAncestry      genAncestry;                                                                    //Per-event decay chain summary of the gen particles (MC only)
+        GenEventView     genEventView;                                                                   //Per-event buckets and eta index of the gen particles for matching (MC only)
+
+        TTree* outputTree;                                                                               //Stream-local tree binding the branch buffers, filled through the OutputMerger
 
         unsigned long _runNb;
         unsigned long _lumiBlock;
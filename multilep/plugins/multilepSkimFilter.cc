@@ -0,0 +1,79 @@
+#include "heavyNeutrino/multilep/plugins/multilepSkimFilter.h"
+
+
+multilepSkimFilter::multilepSkimFilter(const edm::ParameterSet& iConfig):
+    muonToken(                        consumes<std::vector<pat::Muon>>(           iConfig.getParameter<edm::InputTag>("muons"))),
+    eleToken(                         consumes<std::vector<pat::Electron>>(       iConfig.getParameter<edm::InputTag>("electrons"))),
+    tauToken(                         consumes<std::vector<pat::Tau>>(            iConfig.getParameter<edm::InputTag>("taus"))),
+    photonToken(                      consumes<std::vector<pat::Photon>>(         iConfig.getParameter<edm::InputTag>("photons"))),
+    jetToken(                         consumes<std::vector<pat::Jet>>(            iConfig.getParameter<edm::InputTag>("jets"))),
+    skim(                                                                         iConfig.getUntrackedParameter<std::string>("skim")),
+    muonPtMin(                                                                    iConfig.getParameter<double>("muonPtMin")),
+    electronPtMin(                                                                iConfig.getParameter<double>("electronPtMin")),
+    tauPtMin(                                                                     iConfig.getParameter<double>("tauPtMin")),
+    photonPtMin(                                                                  iConfig.getParameter<double>("photonPtMin")),
+    jetPtMin(                                                                     iConfig.getParameter<double>("jetPtMin"))
+{}
+
+// ------------ same skim conditions as in the multilep sub-analyzers, but with looser object definitions  ------------
+bool multilepSkimFilter::filter(edm::StreamID, edm::Event& iEvent, const edm::EventSetup& iSetup) const{
+    bool pass = true;
+    if(skim == "trilep")            pass = countLeptons(iEvent, 3, false) >= 3;
+    else if(skim == "dilep")        pass = countLeptons(iEvent, 2, false) >= 2;
+    else if(skim == "singlelep")    pass = countLeptons(iEvent, 1, false) >= 1;
+    else if(skim == "ttg")          pass = countLeptons(iEvent, 2, true) >= 2 and countPhotons(iEvent, 1) >= 1;
+    else if(skim == "FR")           pass = countLeptons(iEvent, 1, true) >= 1 and countJets(iEvent, 1) >= 1;
+    else if(skim == "singlejet")    pass = countJets(iEvent, 1) >= 1;
+    else if(skim == "singlephoton") pass = countPhotons(iEvent, 1) >= 1;
+    else if(skim == "diphoton")     pass = countPhotons(iEvent, 2) >= 2;
+    return pass;
+}
+
+// ------------ counting stops as soon as the needed number of objects is found  ------------
+unsigned multilepSkimFilter::countLeptons(const edm::Event& iEvent, const unsigned needed, const bool onlyLight) const{
+    edm::Handle<std::vector<pat::Muon>> muons;         iEvent.getByToken(muonToken, muons);
+    edm::Handle<std::vector<pat::Electron>> electrons; iEvent.getByToken(eleToken,  electrons);
+
+    unsigned count = 0;
+    for(const pat::Muon& mu : *muons){
+        if(mu.pt() < muonPtMin or fabs(mu.eta()) > 2.4)         continue;
+        if(++count == needed) return count;
+    }
+    for(const pat::Electron& ele : *electrons){
+        if(ele.pt() < electronPtMin or fabs(ele.eta()) > 2.5)   continue;
+        if(++count == needed) return count;
+    }
+    if(onlyLight) return count;
+
+    edm::Handle<std::vector<pat::Tau>> taus;           iEvent.getByToken(tauToken,  taus);
+    for(const pat::Tau& tau : *taus){
+        if(tau.pt() < tauPtMin or fabs(tau.eta()) > 2.3)        continue;
+        if(++count == needed) return count;
+    }
+    return count;
+}
+
+unsigned multilepSkimFilter::countPhotons(const edm::Event& iEvent, const unsigned needed) const{
+    edm::Handle<std::vector<pat::Photon>> photons;     iEvent.getByToken(photonToken, photons);
+
+    unsigned count = 0;
+    for(const pat::Photon& photon : *photons){
+        if(photon.pt() < photonPtMin or fabs(photon.eta()) > 2.5) continue;
+        if(++count == needed) return count;
+    }
+    return count;
+}
+
+unsigned multilepSkimFilter::countJets(const edm::Event& iEvent, const unsigned needed) const{
+    edm::Handle<std::vector<pat::Jet>> jets;           iEvent.getByToken(jetToken, jets);
+
+    unsigned count = 0;
+    for(const pat::Jet& jet : *jets){
+        if(jet.pt() < jetPtMin)                                 continue;
+        if(++count == needed) return count;
+    }
+    return count;
+}
+
+//define this as a plug-in
+DEFINE_FWK_MODULE(multilepSkimFilter);
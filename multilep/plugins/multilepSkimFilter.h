@@ -0,0 +1,47 @@
+#ifndef MULTILEP_SKIM_FILTER_H
+#define MULTILEP_SKIM_FILTER_H
+
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "FWCore/Framework/interface/global/EDFilter.h"
+
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+#include "DataFormats/PatCandidates/interface/Electron.h"
+#include "DataFormats/PatCandidates/interface/Muon.h"
+#include "DataFormats/PatCandidates/interface/Tau.h"
+#include "DataFormats/PatCandidates/interface/Photon.h"
+#include "DataFormats/PatCandidates/interface/Jet.h"
+
+/*
+ * Lightweight skim filter, to be put at the head of the path in front of the egamma, jet and MET sequences
+ * Counts the slimmed objects with kinematic cuts which are looser than the multilep preselection (to allow for the later energy corrections and smearing),
+ * such that the expensive sequences only run on events which have a chance to pass the skim in multilep
+ * The multilep ntuplizer sits behind it on the same path, the event counters are filled by a second multilep instance in the EndPath
+ */
+class multilepSkimFilter : public edm::global::EDFilter<> {
+    public:
+        explicit multilepSkimFilter(const edm::ParameterSet&);
+        ~multilepSkimFilter(){};
+
+    private:
+        edm::EDGetTokenT<std::vector<pat::Muon>>     muonToken;
+        edm::EDGetTokenT<std::vector<pat::Electron>> eleToken;
+        edm::EDGetTokenT<std::vector<pat::Tau>>      tauToken;
+        edm::EDGetTokenT<std::vector<pat::Photon>>   photonToken;
+        edm::EDGetTokenT<std::vector<pat::Jet>>      jetToken;
+        std::string                                  skim;
+        double                                       muonPtMin;
+        double                                       electronPtMin;
+        double                                       tauPtMin;
+        double                                       photonPtMin;
+        double                                       jetPtMin;
+
+        virtual bool filter(edm::StreamID, edm::Event&, const edm::EventSetup&) const override;
+
+        unsigned countLeptons(const edm::Event&, const unsigned needed, const bool onlyLight) const;
+        unsigned countPhotons(const edm::Event&, const unsigned needed) const;
+        unsigned countJets(const edm::Event&, const unsigned needed) const;
+};
+#endif
@@ -22,24 +22,21 @@ def addJetSequence(process, isData, is2017, is2018):
 
   #
   # Jet energy resolution, see https://twiki.cern.ch/twiki/bin/view/CMS/JetResolution#Smearing_procedures
-  # Run three times the SmearedPATJetProducer for nominal, up and down variations
+  # The jetSmearingProducer does the nominal, down and up variations in one go, and stores the smeared pt
+  # as ValueMaps (instances pt, ptDown and ptUp) keyed to the jets in src
   #
   if not isData:
-    for (i, j) in [(0, ''), (-1, 'Down'), (1, 'Up')]:
-      jetSmearing = cms.EDProducer('SmearedPATJetProducer',
-        src          = cms.InputTag('selectedUpdatedPatJetsUpdatedJEC'),
-        enabled      = cms.bool(True),
-        rho          = cms.InputTag("fixedGridRhoFastjetAll"),
-        algo         = cms.string('AK4PFchs'),
-        algopt       = cms.string('AK4PFchs_pt'),
-        genJets      = cms.InputTag('slimmedGenJets'),
-        dRMax        = cms.double(0.2),
-        dPtMaxFactor = cms.double(3),
-        debug        = cms.untracked.bool(False),
-        variation    = cms.int32(i),
-      )
-      setattr(process, 'slimmedJetsCorrectedAndSmeared'+j, jetSmearing)
-      process.jetSequence *= jetSmearing
+    process.jetSmearing = cms.EDProducer('jetSmearingProducer',
+      src          = cms.InputTag('selectedUpdatedPatJetsUpdatedJEC'),
+      rho          = cms.InputTag("fixedGridRhoFastjetAll"),
+      algo         = cms.string('AK4PFchs'),
+      algopt       = cms.string('AK4PFchs_pt'),
+      genJets      = cms.InputTag('slimmedGenJets'),
+      dRMax        = cms.double(0.2),
+      dPtMaxFactor = cms.double(3),
+      seed         = cms.uint32(37428479),    # default seed of the SmearedPATJetProducer
+    )
+    process.jetSequence *= process.jetSmearing
 
   # Propagate JEC to MET (need to add fullPatMetSequence to path)
   # https://twiki.cern.ch/twiki/bin/view/CMS/MissingETUncertaintyPrescription#Instructions_for_9_4_X_X_9_or_10
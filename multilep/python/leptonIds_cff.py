@@ -0,0 +1,42 @@
+import FWCore.ParameterSet.Config as cms
+
+#
+# Working points of the HN and ewkino lepton ids as cut tables, evaluated by LeptonAnalyzer::computeLeptonIds in one pass over the leptons
+# Cuts which are not given are not applied, FO requires loose and tight requires FO of the same family
+# A lepton passes when its value is > min* or < max* (maxMissingHits: <=), and either the SUSY16 lepton MVA > minLeptonMva
+# or, when minPtRatio is given, ptRatio > minPtRatio and closest jet csvV2 < maxClosestJetCsv (and the alternativeElectronMva for electrons)
+# Electron MVA working points: HNFO, SUSYLoose, SUSYTight, EwkFO [tuned on very old electron MVAs, do NOT use them for new analyses]
+#
+def vertexCuts():
+  return dict(maxDxy = cms.double(0.05), maxDz = cms.double(0.1))
+
+def getLeptonIds(is2017, is2018):
+  # Currently the same for all eras
+  return cms.PSet(
+    hnLoose = cms.PSet(                                   # own-made loose, not POG-loose
+      muon     = cms.PSet(minPt = cms.double(5),  maxRelIso = cms.double(0.6), looseMuon = cms.bool(True), **vertexCuts()),
+      electron = cms.PSet(minPt = cms.double(10), maxRelIso = cms.double(0.6), maxMissingHits = cms.uint32(1), convVeto = cms.bool(True), muonOverlap = cms.bool(True), **vertexCuts()),
+    ),
+    hnFO = cms.PSet(
+      muon     = cms.PSet(max3dIPSig = cms.double(4), mediumMuon = cms.bool(True)),
+      electron = cms.PSet(max3dIPSig = cms.double(4), maxMissingHits = cms.uint32(0), triggerEmulation = cms.bool(True), electronMva = cms.string('HNFO')),
+    ),
+    hnTight = cms.PSet(
+      muon     = cms.PSet(maxRelIso = cms.double(0.1)),
+      electron = cms.PSet(maxRelIso = cms.double(0.1), electronMva = cms.string('SUSYTight')),
+    ),
+    ewkLoose = cms.PSet(
+      muon     = cms.PSet(minPt = cms.double(5), maxEta = cms.double(2.4), max3dIPSig = cms.double(8), maxMiniIso = cms.double(0.4), looseMuon = cms.bool(True), **vertexCuts()),
+      electron = cms.PSet(minPt = cms.double(7), maxEta = cms.double(2.5), max3dIPSig = cms.double(8), maxMiniIso = cms.double(0.4), maxMissingHits = cms.uint32(1),
+                          muonOverlap = cms.bool(True), electronMva = cms.string('SUSYLoose'), **vertexCuts()),
+    ),
+    ewkFO = cms.PSet(
+      muon     = cms.PSet(minPt = cms.double(10), mediumMuon = cms.bool(True), minLeptonMva = cms.double(-0.2), minPtRatio = cms.double(0.3), maxClosestJetCsv = cms.double(0.3)),
+      electron = cms.PSet(minPt = cms.double(10), triggerEmulationNoHOverE = cms.bool(True), maxMissingHits = cms.uint32(0), hOverEConePt = cms.double(30),
+                          minLeptonMva = cms.double(0.5), minPtRatio = cms.double(0.3), maxClosestJetCsv = cms.double(0.3), alternativeElectronMva = cms.string('EwkFO')),
+    ),
+    ewkTight = cms.PSet(
+      muon     = cms.PSet(minLeptonMva = cms.double(-0.2)),
+      electron = cms.PSet(triggerEmulation = cms.bool(True), convVeto = cms.bool(True), minLeptonMva = cms.double(0.5)),
+    ),
+  )
@@ -14,6 +14,11 @@
 
 
 GenAnalyzer::GenAnalyzer(const edm::ParameterSet& iConfig, multilep* multilepAnalyzer):
+    overlapConfigs({
+        {13., 3.0},                                                                          // ttG: for TTGamma_Dilept_TuneCUETP8M2T4_13TeV-amcatnlo-pythia8
+        {15., 2.6}                                                                           // ZG:  for ZGToLLG_01J_5f_TuneCUETP8M1_13TeV-amcatnloFXFX-pythia8
+    }),
+    overlapTypes(overlapConfigs.size()),
     multilepAnalyzer(multilepAnalyzer){};
 
 void GenAnalyzer::beginJob(TTree* outputTree){
@@ -50,8 +55,9 @@ void GenAnalyzer::analyze(const edm::Event& iEvent){
     if(!genParticles.isValid()) return;
 
     // TODO: when applying overlap for new photon samples: check the pt and eta cuts of the photon
-    _ttgEventType = overlapEventType(*genParticles, 13., 3.0); // for TTGamma_Dilept_TuneCUETP8M2T4_13TeV-amcatnlo-pythia8
-    _zgEventType  = overlapEventType(*genParticles, 15., 2.6); // for ZGToLLG_01J_5f_TuneCUETP8M1_13TeV-amcatnloFXFX-pythia8
+    overlapEventType(*genParticles, overlapConfigs, overlapTypes);
+    _ttgEventType = overlapTypes[0];
+    _zgEventType  = overlapTypes[1];
 
     _gen_nL = 0;
     _gen_nPh = 0;
@@ -78,8 +84,8 @@ void GenAnalyzer::analyze(const edm::Event& iEvent){
                 _gen_lCharge[_gen_nL]        = p.charge();
                 _gen_lIsPrompt[_gen_nL]      = GenTools::isPrompt(p, *genParticles);
                 _gen_lMomPdg[_gen_nL]        = GenTools::getMother(p, *genParticles)->pdgId();
-                _gen_lMinDeltaR[_gen_nL]     = GenTools::getMinDeltaR(p, *genParticles);
-                _gen_lPassParentage[_gen_nL] = GenTools::passParentage(p, *genParticles);
+                _gen_lMinDeltaR[_gen_nL]     = GenTools::getMinDeltaR(p, multilepAnalyzer->genEventView);
+                _gen_lPassParentage[_gen_nL] = GenTools::passParentage(p, multilepAnalyzer->genAncestry);
 
                 if(absId == 11)      _gen_lFlavor[_gen_nL] = 0;
                 else if(absId == 13) _gen_lFlavor[_gen_nL] = 1;
@@ -98,8 +104,8 @@ void GenAnalyzer::analyze(const edm::Event& iEvent){
                 _gen_phE[_gen_nPh]             = p.energy();
                 _gen_phIsPrompt[_gen_nPh]      = p.isPromptFinalState();
                 _gen_phMomPdg[_gen_nPh]        = GenTools::getMother(p, *genParticles)->pdgId();
-                _gen_phMinDeltaR[_gen_nPh]     = GenTools::getMinDeltaR(p, *genParticles);
-                _gen_phPassParentage[_gen_nPh] = GenTools::passParentage(p, *genParticles);
+                _gen_phMinDeltaR[_gen_nPh]     = GenTools::getMinDeltaR(p, multilepAnalyzer->genEventView);
+                _gen_phPassParentage[_gen_nPh] = GenTools::passParentage(p, multilepAnalyzer->genAncestry);
                 ++_gen_nPh;
             } 
         }
@@ -112,34 +118,38 @@ void GenAnalyzer::analyze(const edm::Event& iEvent){
 
 /*
  * Some event categorization in order to understand/debug/apply overlap removal for TTGamma <--> TTJets and similar photon samples
+ * The type is evaluated for several photon pt and eta cuts at once: the classification of a photon does not depend on the cuts,
+ * so it is done only once per photon, and only for photons passing the cuts of at least one configuration
  */
-unsigned GenAnalyzer::overlapEventType(const std::vector<reco::GenParticle>& genParticles, double ptCut, double etaCut) const{
-    int type = 0;
+void GenAnalyzer::overlapEventType(const std::vector<reco::GenParticle>& genParticles, const std::vector<OverlapConfig>& configs, std::vector<unsigned>& types) const{
+    types.assign(configs.size(), 0);
     for(auto p = genParticles.cbegin(); p != genParticles.cend(); ++p){
         if(p->status()<0)         continue;
         if(p->pdgId()!=22)        continue;
-        type = std::max(type, 1);                                                            // Type 1: final state photon found in genparticles with generator level cuts
-        if(p->pt()<ptCut)         continue;
-        if(fabs(p->eta())>etaCut) continue;
-        type = std::max(type, 2);                                                            // Type 2: photon from pion or other meson
-
-        if(GenTools::getMinDeltaR(*p, genParticles) < 0.2) continue;
-        if(not GenTools::passParentage(*p, genParticles))  continue;
-
-        // Everything below is *signal*
-        std::set<int> decayChain;
-        GenTools::setDecayChain(*p, genParticles, decayChain);
-        const reco::GenParticle* mom = GenTools::getMother(*p, genParticles);
-        if(std::any_of(decayChain.cbegin(), decayChain.cend(), [](const int entry){ return abs(entry) == 24;})){
-            if(abs(mom->pdgId()) == 24)     type = std::max(type, 6);      // Type 6: photon directly from W or decay products which are part of ME
-            else if(abs(mom->pdgId()) <= 6) type = std::max(type, 4);      // Type 4: photon from quark from W (photon from pythia, rarely)
-            else                            type = std::max(type, 5);      // Type 5: photon from lepton from W (photon from pythia)
-        } else {
-            if(abs(mom->pdgId()) == 6)      type = std::max(type, 7);      // Type 7: photon from top
-            else if(abs(mom->pdgId()) == 5) type = std::max(type, 3);      // Type 3: photon from b
-            else                            type = std::max(type, 8);      // Type 8: photon from ME
+        unsigned photonType = 0;                                                             // classification of this photon, 0 until needed
+        for(unsigned c = 0; c < configs.size(); ++c){
+            types[c] = std::max(types[c], 1u);                                               // Type 1: final state photon found in genparticles with generator level cuts
+            if(p->pt()<configs[c].ptCut)         continue;
+            if(fabs(p->eta())>configs[c].etaCut) continue;
+            if(photonType == 0) photonType = overlapPhotonType(*p, genParticles);
+            types[c] = std::max(types[c], photonType);
         }
     }
+}
 
-    return type;
+unsigned GenAnalyzer::overlapPhotonType(const reco::GenParticle& p, const std::vector<reco::GenParticle>& genParticles) const{
+    if(GenTools::getMinDeltaR(p, multilepAnalyzer->genEventView) < 0.2) return 2;           // Type 2: photon from pion or other meson
+    if(not GenTools::passParentage(p, multilepAnalyzer->genAncestry))   return 2;
+
+    // Everything below is *signal*
+    const reco::GenParticle* mom = GenTools::getMother(p, genParticles);
+    if(multilepAnalyzer->genAncestry.inChain(p, GenAncestry::W)){
+        if(abs(mom->pdgId()) == 24)     return 6;                                            // Type 6: photon directly from W or decay products which are part of ME
+        else if(abs(mom->pdgId()) <= 6) return 4;                                            // Type 4: photon from quark from W (photon from pythia, rarely)
+        else                            return 5;                                            // Type 5: photon from lepton from W (photon from pythia)
+    } else {
+        if(abs(mom->pdgId()) == 6)      return 7;                                            // Type 7: photon from top
+        else if(abs(mom->pdgId()) == 5) return 3;                                            // Type 3: photon from b
+        else                            return 8;                                            // Type 8: photon from ME
+    }
 }
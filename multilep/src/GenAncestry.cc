@@ -0,0 +1,77 @@
+#include "heavyNeutrino/multilep/interface/GenAncestry.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+/*
+ * Classification of a single particle in the decay chain, as done by the former *InChain functions on every entry of the chain
+ */
+unsigned GenAncestry::particleFlags(const int pdgId){
+    if(pdgId == 2212) return 0;                                                  // protons are not part of the decay chain, antiprotons are
+    const unsigned absId        = abs(pdgId);
+    const unsigned mod          = absId%10000;
+    const unsigned baryonNumber = (absId/1000)%10;
+
+    unsigned flags = nonEmpty;
+    if((absId > 22 && absId < 26) || absId == 9900012)  flags |= boson;
+    if(baryonNumber == 5)                               flags |= bBaryon;
+    if(mod >= 500 && mod < 600)                         flags |= bMeson;
+    if(baryonNumber == 4)                               flags |= cBaryon;
+    if(mod >= 400 && mod < 500)                         flags |= cMeson;
+    if(baryonNumber == 3)                               flags |= sBaryon;
+    if((mod >= 100 && mod < 400) || pdgId == 21)        flags |= lightMeson;
+    if((baryonNumber == 1 || baryonNumber == 2) && absId != 2212) flags |= lightBaryon; // an antiproton is not a light baryon
+    if(pdgId == 111)                                    flags |= pi0;
+    if(pdgId == 22)                                     flags |= photon;
+    if(absId == 15)                                     flags |= tau;
+    if(absId == 24)                                     flags |= W;
+    if(absId < 7)                                       flags |= quark;
+    return flags;
+}
+
+
+GenAncestry::Chain GenAncestry::combine(const reco::GenParticle& gen) const{
+    Chain chain;
+    chain.flags = particleFlags(gen.pdgId());
+    if(chain.flags){
+        chain.maxPdgId = gen.pdgId();
+        chain.minPdgId = gen.pdgId();
+    }
+    for(unsigned m = 0; m < std::min(gen.numberOfMothers(), (size_t) 2); ++m){
+        const Chain& mother       = chains[gen.motherRef(m).key()];
+        chain.flags              |= mother.flags;
+        chain.maxPdgId            = std::max(chain.maxPdgId, mother.maxPdgId);
+        chain.minPdgId            = std::min(chain.minPdgId, mother.minPdgId);
+        chain.onlyIncomingGluons &= mother.onlyIncomingGluons;
+    }
+    if(gen.pdgId() == 21 and (chain.flags & quark)) chain.onlyIncomingGluons = false;                   //found a gluon with a quark in the decay chain
+    return chain;
+}
+
+
+void GenAncestry::resolve(const unsigned index){
+    const reco::GenParticle& gen = (*genParticles)[index];
+    states[index] = 1;
+    for(unsigned m = 0; m < std::min(gen.numberOfMothers(), (size_t) 2); ++m){
+        unsigned mother = gen.motherRef(m).key();
+        if(states[mother] == 0) resolve(mother);
+    }
+    chains[index] = combine(gen);
+    states[index] = 2;
+}
+
+
+void GenAncestry::fill(const std::vector<reco::GenParticle>& particles){
+    genParticles = &particles;
+    chains.assign(particles.size(), Chain());
+    states.assign(particles.size(), 0);
+    for(unsigned i = 0; i < particles.size(); ++i){
+        if(states[i] == 0) resolve(i);
+    }
+}
+
+
+GenAncestry::Chain GenAncestry::chain(const reco::GenParticle& gen) const{
+    if(genParticles and !genParticles->empty() and &gen >= &genParticles->front() and &gen <= &genParticles->back()) return chains[&gen - &genParticles->front()];
+    return combine(gen);
+}
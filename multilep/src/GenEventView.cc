@@ -0,0 +1,67 @@
+#include "heavyNeutrino/multilep/interface/GenEventView.h"
+#include "DataFormats/Math/interface/deltaR.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const double etaMargin = 0.001;                                                                      //protects the windows against rounding, the exact cuts are applied by the callers
+}
+
+void GenEventView::EtaIndex::sort(){
+    std::sort(entries.begin(), entries.end());
+}
+
+void GenEventView::EtaIndex::query(const double eta, const double window, std::vector<unsigned>& indices) const{
+    auto entry = std::lower_bound(entries.begin(), entries.end(), std::make_pair(eta - window - etaMargin, 0u));
+    for(; entry != entries.end() and entry->first <= eta + window + etaMargin; ++entry) indices.push_back(entry->second);
+}
+
+
+void GenEventView::fill(const std::vector<reco::GenParticle>& particles){
+    genParticles = &particles;
+    for(auto& bucket : matchingBuckets) bucket.second.clear();
+    photonMatching.clear();
+    minDeltaRParticles.clear();
+
+    for(unsigned i = 0; i < particles.size(); ++i){
+        const reco::GenParticle& p = particles[i];
+        unsigned absId = abs(p.pdgId());
+        if(absId == 15 ? (p.status() == 2 and p.isLastCopy()) : p.status() == 1)            matchingBuckets[absId].add(p.eta(), i);
+        if(p.status() == 1 or p.status() == 71)                                              photonMatching.add(p.eta(), i);
+        if(p.status() == 1 and p.pt() >= minDeltaRPtCut and absId != 12 and absId != 14 and absId != 16) minDeltaRParticles.add(p.eta(), i);
+    }
+    for(auto& bucket : matchingBuckets) bucket.second.sort();
+    photonMatching.sort();
+    minDeltaRParticles.sort();
+}
+
+
+void GenEventView::matchingCandidates(const unsigned absPdgId, const double eta, const double window, std::vector<unsigned>& indices) const{
+    auto bucket = matchingBuckets.find(absPdgId);
+    if(bucket != matchingBuckets.end()) bucket->second.query(eta, window, indices);
+}
+
+
+void GenEventView::photonMatchingCandidates(const double eta, const double window, std::vector<unsigned>& indices) const{
+    photonMatching.query(eta, window, indices);
+}
+
+
+/*
+ * Nearest neighbour search, walking away from the eta of the particle in both directions until the eta distance alone exceeds the minimum found
+ */
+double GenEventView::minDeltaR(const reco::GenParticle& p) const{
+    double minDeltaR = 10;
+    const auto& entries = minDeltaRParticles.sorted();
+    auto consider = [&](const unsigned index){
+        const reco::GenParticle& q = (*genParticles)[index];
+        if(fabs(p.pt()-q.pt()) < 0.0001) return;                                                        // same particle
+        minDeltaR = std::min(minDeltaR, reco::deltaR(p.eta(), p.phi(), q.eta(), q.phi()));
+    };
+
+    auto start = std::lower_bound(entries.begin(), entries.end(), std::make_pair(p.eta(), 0u));
+    for(auto up = start; up != entries.end() and up->first - p.eta() <= minDeltaR + etaMargin; ++up) consider(up->second);
+    for(auto down = start; down != entries.begin() and p.eta() - (down - 1)->first <= minDeltaR + etaMargin; --down) consider((down - 1)->second);
+    return minDeltaR;
+}
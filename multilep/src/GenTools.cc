@@ -3,6 +3,8 @@
 //include ROOT classes
 #include "TLorentzVector.h"
 
+#include <algorithm>
+
 const reco::GenParticle* GenTools::getFirstMother(const reco::GenParticle& gen, const std::vector<reco::GenParticle>& genParticles){
     return (gen.numberOfMothers() == 0) ? nullptr : &genParticles[gen.motherRef(0).key()];
 }
@@ -14,79 +16,6 @@ const reco::GenParticle* GenTools::getMother(const reco::GenParticle& gen, const
     else return mom;
 }
 
-void GenTools::setDecayChain(const reco::GenParticle& gen, const std::vector<reco::GenParticle>& genParticles, std::set<int>& list){
-    if((list.empty() or list.find(gen.pdgId())==list.end()) and gen.pdgId() != 2212) list.insert(gen.pdgId());
-    if(gen.numberOfMothers() > 1) setDecayChain(genParticles[gen.motherRef(1).key()], genParticles, list);
-    if(gen.numberOfMothers() > 0) setDecayChain(genParticles[gen.motherRef(0).key()], genParticles, list);
-}
-
-bool GenTools::hasOnlyIncomingGluonsInChain(const reco::GenParticle& gen, const std::vector<reco::GenParticle>& genParticles){
-    if(gen.pdgId()==21){
-      std::set<int> chain;
-      GenTools::setDecayChain(gen, genParticles, chain);
-      if(std::any_of(chain.cbegin(), chain.cend(), [](const int entry){return abs(entry) < 7;})) return false; // found a gluon with a quark in the decay chain
-    }
-    if(gen.numberOfMothers() > 1 and not hasOnlyIncomingGluonsInChain(genParticles[gen.motherRef(1).key()], genParticles)) return false;
-    if(gen.numberOfMothers() > 0 and not hasOnlyIncomingGluonsInChain(genParticles[gen.motherRef(0).key()], genParticles)) return false;
-    return true;
-}
-
-bool GenTools::bosonInChain(const std::set<int>& chain){ // what is the point of finding a majorana HN here? and why not Dirac HN?
-   return std::any_of(chain.cbegin(), chain.cend(), [](const int entry){ return (abs(entry) > 22 && abs(entry) < 26) || (abs(entry) == 9900012);});
-}
- 
-bool GenTools::bBaryonInChain(const std::set<int>& chain){
-   return std::any_of(chain.cbegin(), chain.cend(), [](const int entry){ return (abs(entry)/1000)%10 == 5;});
-}
-
-bool GenTools::bMesonInChain(const std::set<int>& chain){
-   return std::any_of(chain.cbegin(), chain.cend(), [](const int entry){ unsigned mod = abs(entry)%10000; return mod >= 500 && mod < 600;});
-}
-
-bool GenTools::cBaryonInChain(const std::set<int>& chain){
-   return std::any_of(chain.cbegin(), chain.cend(), [](const int entry){ return (abs(entry)/1000)%10 == 4;});
-}
-
-bool GenTools::cMesonInChain(const std::set<int>& chain){
-    return std::any_of(chain.cbegin(), chain.cend(), [](const int entry){ unsigned mod = abs(entry)%10000; return mod >= 400 && mod < 500;});
-}
-
-bool GenTools::sBaryonInChain(const std::set<int>& chain){
-    return std::any_of(chain.cbegin(), chain.cend(), [](const int entry){ return (abs(entry)/1000)%10 == 3;});
-}
-
-bool GenTools::lightMesonInChain(const std::set<int>& chain){
-    return std::any_of(chain.cbegin(), chain.cend(), [](const int entry){ unsigned mod = abs(entry)%10000; return (mod >= 100 && mod < 400) || entry == 21;});
-}
-
-bool GenTools::lightBaryonInChain(const std::set<int>& chain){
-    return std::any_of(chain.cbegin(), chain.cend(),
-            [](const int entry){
-                if(abs(entry) == 2212) return false; // useless? there are no protons saved in the chain; actually those wo do appear you want to have here
-                unsigned red = (abs(entry)/1000)%10; 
-                return (red == 1 || red == 2); 
-            });
-}
-
-bool GenTools::pi0InChain(const std::set<int>& chain){
-    return chain.count(111);
-}
-
-bool GenTools::photonInChain(const std::set<int>& chain){
-    return chain.count(22);
-}
-
-bool GenTools::tauInChain(const std::set<int>& chain){
-    return chain.count(15) or chain.count(-15);
-}
-
-bool GenTools::udsInChain(const std::set<int>& chain){
-    if(sBaryonInChain(chain))       return true;
-    if(lightMesonInChain(chain))    return true;
-    if(lightBaryonInChain(chain))   return true;
-    return false;
-}
-
 //enumerated type to specify decay
 enum decayType {
     W_L,
@@ -110,59 +39,58 @@ enum decayType {
     F_L
 };
 
-unsigned GenTools::provenance(const reco::GenParticle* gen, const std::vector<reco::GenParticle>& genParticles){
+unsigned GenTools::provenance(const reco::GenParticle* gen, const GenAncestry& ancestry){
     if(!gen) return F_L; 
 
-    std::set<int> decayChain;
-    setDecayChain(*gen, genParticles, decayChain);
+    const unsigned decayChain = ancestry.chain(*gen).flags;
+    auto inChain = [decayChain](const unsigned flags){ return (decayChain & flags) != 0; };
     //first consider decays involving a boson
-    if(bosonInChain(decayChain)){
-      if(bMesonInChain(decayChain)){
-        if(cMesonInChain(decayChain)){
-          if(tauInChain(decayChain))  return W_B_C_T_L;
-          else                        return W_B_C_L;
+    if(inChain(GenAncestry::boson)){
+      if(inChain(GenAncestry::bMeson)){
+        if(inChain(GenAncestry::cMeson)){
+          if(inChain(GenAncestry::tau))  return W_B_C_T_L;
+          else                           return W_B_C_L;
         }
-        if(tauInChain(decayChain))    return W_B_T_L;
-        else                          return W_B_L;
+        if(inChain(GenAncestry::tau))    return W_B_T_L;
+        else                             return W_B_L;
       }
-      if(cMesonInChain(decayChain)){
-        if(tauInChain(decayChain))    return W_C_T_L;
-        else                          return W_C_L;
+      if(inChain(GenAncestry::cMeson)){
+        if(inChain(GenAncestry::tau))    return W_C_T_L;
+        else                             return W_C_L;
       }
-      if(udsInChain(decayChain))      return pi_0;
-      if(tauInChain(decayChain))      return W_T_L;
-      else                            return W_L;
+      if(inChain(GenAncestry::uds))      return pi_0;
+      if(inChain(GenAncestry::tau))      return W_T_L;
+      else                               return W_L;
     }
-    if(bMesonInChain(decayChain)){
-      if(cMesonInChain(decayChain)){
-        if(tauInChain(decayChain))    return B_C_T_L;
-        else                          return B_C_L;
+    if(inChain(GenAncestry::bMeson)){
+      if(inChain(GenAncestry::cMeson)){
+        if(inChain(GenAncestry::tau))    return B_C_T_L;
+        else                             return B_C_L;
       }
-      if(tauInChain(decayChain))      return B_T_L;
-      else                            return B_L;
+      if(inChain(GenAncestry::tau))      return B_T_L;
+      else                               return B_L;
     }
-    if(cMesonInChain(decayChain)){
-      if(tauInChain(decayChain))      return C_T_L;
-      else                            return C_L;
+    if(inChain(GenAncestry::cMeson)){
+      if(inChain(GenAncestry::tau))      return C_T_L;
+      else                               return C_L;
     }
-    if(bBaryonInChain(decayChain))    return B_Baryon;
-    if(cBaryonInChain(decayChain))    return C_Baryon;
-    if(udsInChain(decayChain))        return pi_0;
-    if(photonInChain(decayChain))     return photon_;
+    if(inChain(GenAncestry::bBaryon))    return B_Baryon;
+    if(inChain(GenAncestry::cBaryon))    return C_Baryon;
+    if(inChain(GenAncestry::uds))        return pi_0;
+    if(inChain(GenAncestry::photon))     return photon_;
     return F_L;
 }
 
-unsigned GenTools::provenanceCompressed(const reco::GenParticle* gen, const std::vector<reco::GenParticle>& genParticles, bool isPrompt){
+unsigned GenTools::provenanceCompressed(const reco::GenParticle* gen, const GenAncestry& ancestry, bool isPrompt){
     if(isPrompt) return 0; // This was how it was also defined in the old GenMatching code
     if(!gen) return 4;
 
-    std::set<int> decayChain;
-    setDecayChain(*gen, genParticles, decayChain);
-    if(bMesonInChain(decayChain) || bBaryonInChain(decayChain) ) return 1;          //lepton from heavy flavor decay
-    if(cMesonInChain(decayChain) || cBaryonInChain(decayChain) ) return 2;          //lepton from c flavor decay
-    if(bosonInChain(decayChain) ) return 0;                                         //lepton from boson
-    if(!decayChain.empty()) return 3;                                               //light flavor fake
-    return 4;                                                                       //unkown origin
+    const unsigned decayChain = ancestry.chain(*gen).flags;
+    if(decayChain & (GenAncestry::bMeson | GenAncestry::bBaryon)) return 1;          //lepton from heavy flavor decay
+    if(decayChain & (GenAncestry::cMeson | GenAncestry::cBaryon)) return 2;          //lepton from c flavor decay
+    if(decayChain & GenAncestry::boson)                           return 0;          //lepton from boson
+    if(decayChain & GenAncestry::nonEmpty)                        return 3;          //light flavor fake
+    return 4;                                                                        //unkown origin
 }
 
 unsigned GenTools::provenanceConversion(const reco::GenParticle* photon, const std::vector<reco::GenParticle>& genParticles){
@@ -203,13 +131,12 @@ bool GenTools::isPrompt(const reco::GenParticle& gen, const std::vector<reco::Ge
 /*
  * Check if only quarks, leptons, bosons or incoming gluons are in the parentagelist
  */
-bool GenTools::passParentage(const reco::GenParticle& gen, const std::vector<reco::GenParticle>& genParticles){
-    std::set<int> decayChain;
-    setDecayChain(gen, genParticles, decayChain);
-    if(decayChain.size()==0)                                                    return true;
-    if(*(std::max_element(std::begin(decayChain), std::end(decayChain))) > 37)  return false;
-    if(*(std::min_element(std::begin(decayChain), std::end(decayChain))) < -37) return false;
-    if(not GenTools::hasOnlyIncomingGluonsInChain(gen, genParticles))           return false;
+bool GenTools::passParentage(const reco::GenParticle& gen, const GenAncestry& ancestry){
+    const GenAncestry::Chain decayChain = ancestry.chain(gen);
+    if(!(decayChain.flags & GenAncestry::nonEmpty)) return true;
+    if(decayChain.maxPdgId > 37)                    return false;
+    if(decayChain.minPdgId < -37)                   return false;
+    if(not decayChain.onlyIncomingGluons)           return false;
     return true;
 }
 
@@ -220,16 +147,8 @@ bool GenTools::passParentage(const reco::GenParticle& gen, const std::vector<rec
  * are typically out of the phase space of the generated sample
  * [but this is based on tuning and agreement with other groups, so maybe room for more studies/tuning]
  */
-double GenTools::getMinDeltaR(const reco::GenParticle& p, const std::vector<reco::GenParticle>& genParticles, float ptCut){
-    double minDeltaR = 10;
-    for(auto& q : genParticles){
-        if(q.pt() < ptCut)                                                       continue;
-        if(q.status() != 1)                                                      continue;
-        if(fabs(p.pt()-q.pt()) < 0.0001)                                         continue; // same particle
-        if(abs(q.pdgId()) == 12 or abs(q.pdgId()) == 14 or abs(q.pdgId()) == 16) continue;
-        minDeltaR = std::min(minDeltaR, deltaR(p.eta(), p.phi(), q.eta(), q.phi()));
-    }
-    return minDeltaR;
+double GenTools::getMinDeltaR(const reco::GenParticle& p, const GenEventView& genView){
+    return genView.minDeltaR(p);                                                                         //nearest neighbour among status 1 particles with pt > 5, excluding neutrinos
 }
 
 /*
@@ -243,22 +162,29 @@ bool GenTools::considerForMatching(const reco::Candidate& reco, const reco::GenP
     return gen.status() == 1;
 }
 
-const reco::GenParticle* GenTools::geometricMatch(const reco::Candidate& reco, const std::vector<reco::GenParticle>& genParticles, const bool differentId){
+const reco::GenParticle* GenTools::geometricMatch(const reco::Candidate& reco, const GenEventView& genView, const bool differentId){
+    //only the candidates in an eta window of the 0.2 matching cone are considered, in the order of the collection
+    std::vector<unsigned> candidates;
+    genView.matchingCandidates(abs(reco.pdgId()), reco.eta(), 0.2, candidates);
+    if(differentId and abs(reco.pdgId()) != 22) genView.matchingCandidates(22, reco.eta(), 0.2, candidates);
+    std::sort(candidates.begin(), candidates.end());
+
     reco::GenParticle const* match = nullptr;
     TLorentzVector recoV(reco.px(), reco.py(), reco.pz(), reco.energy());
     double minDeltaR = 99999.;
-    for(auto genIt = genParticles.cbegin(); genIt != genParticles.cend(); ++genIt){
-        if(considerForMatching(reco, *genIt, differentId) ){
-            TLorentzVector genV(genIt->px(), genIt->py(), genIt->pz(), genIt->energy());
+    for(unsigned index : candidates){
+        const reco::GenParticle& gen = genView.particles()[index];
+        if(considerForMatching(reco, gen, differentId) ){
+            TLorentzVector genV(gen.px(), gen.py(), gen.pz(), gen.energy());
             double deltaR = recoV.DeltaR(genV);
             if(deltaR < minDeltaR){
                 minDeltaR = deltaR;
-                match = &*genIt;
+                match = &gen;
             }
         }
     } 
     if(minDeltaR > 0.2){
-      if(!differentId) match = geometricMatch(reco, genParticles, true);
+      if(!differentId) match = geometricMatch(reco, genView, true);
       else             return nullptr;
     }
     return match;
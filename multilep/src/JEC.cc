@@ -5,115 +5,129 @@
 
 #include "heavyNeutrino/multilep/interface/JEC.h"
 
-JEC::JEC(const std::string& JECPath, bool dataSample, bool fall17Sample): // need fall2018Sample ?
-    path(JECPath), isData(dataSample), is2017(fall17Sample), is2018(fall17Sample), currentJEC("none") {}
-
-JEC::~JEC(){}
-
-void JEC::updateJEC(const unsigned long runNumber){
-    if(getJECName(runNumber) != currentJEC){
-        currentJEC = getJECName(runNumber);
-        setJEC(getJECName(runNumber) );
-    }
+#include <algorithm>
+#include <iostream>
+
+namespace {
+    struct EraRange {
+        unsigned long firstRun;
+        std::string   runName;
+        std::string   warning;                                                                        //empty when the era has JEC
+    };
+
+    //run ranges of the JEC eras, the first era starts at run 0
+    const std::vector<EraRange> eras2016 = {{0,      "A",   "no JEC available for 2016 run A, seems like JSON file is not applied!"},
+                                            {271658, "BCD", ""},
+                                            {276812, "EF",  ""},
+                                            {278809, "GH",  ""},
+                                            {294645, "",    ""}};
+    const std::vector<EraRange> eras2017 = {{0,      "A",   "no JEC available for 2017 run A, seems like JSON file is not applied!"},
+                                            {297020, "B",   ""},
+                                            {299337, "C",   ""},
+                                            {302030, "D",   ""},
+                                            {303435, "E",   ""},
+                                            {304911, "F",   ""},
+                                            {306464, "GH",  "no JEC available for 2017 runs G-H, they are not 13 TeV data! Seems like JSON file is not applied"}};
+    const std::vector<EraRange> eras2018 = {{0,      "F",   "no JEC available/inmplemented for 2018! Check multilep/src/JEC.cc, currently as a test taking 2017F"}}; //TODO
 }
 
-void JEC::setJEC(const std::string& JECName){
-    std::vector< JetCorrectorParameters > JECParameters;
-    JECParameters.push_back(JetCorrectorParameters( path + JECName + "_L1FastJet_AK4PFchs.txt") );
-    JECParameters.push_back(JetCorrectorParameters( path + JECName + "_L2Relative_AK4PFchs.txt") );
-    JECParameters.push_back(JetCorrectorParameters( path + JECName + "_L3Absolute_AK4PFchs.txt") );
-    if(isData) JECParameters.push_back(JetCorrectorParameters( path + JECName + "_L2L3Residual_AK4PFchs.txt") );
-    jetCorrector.reset(new FactorizedJetCorrector(JECParameters) );
-    jetUncertainties.reset(new JetCorrectionUncertainty(path + JECName + "_Uncertainty_AK4PFchs.txt") );
-}
-   
-std::string JEC::getJECRunName(const unsigned long runNumber){
+/*
+ * The JEC names of all eras of the sample are built once, the text files of an era are parsed the first time one of its runs is seen
+ * and kept, such that switching between eras in a data job only costs a binary search on the run number
+ */
+JEC::JEC(const std::string& JECPath, bool dataSample, bool fall17Sample, bool fall18Sample):
+    path(JECPath), isData(dataSample), is2017(fall17Sample), is2018(fall18Sample)
+{
     ///////////////////////////
     static const std::string version2016 = "_V9";
     static const std::string version2017 = "_V6";
     static const std::string version2018 = "_V6"; // TODO
     //////////////////////////
-    std::string jecName;
+    std::string campaign = (is2017 or is2018) ? "Fall17_17Nov2017" : "Summer16_07Aug2017";          //TODO: 2018
+    std::string version  = is2018 ? version2018 : (is2017 ? version2017 : version2016);
+
     if(isData){
-        if(is2018){
-            std::cout << "no JEC available/inmplemented for 2018! Check multilep/src/JEC.cc, currently as a test taking 2017GH" << std::endl;
-            jecName = "_GH"; //TODO
-            jecName += version2018;
-        } else if(is2017){
-            if(runNumber < 297020){
-                jecName = "A";
-                std::cerr << "no JEC available for 2017 run A, seems like JSON file is not applied!" << std::endl;
-            } 
-            else if(runNumber < 299337) jecName = "B";
-            else if(runNumber < 302030) jecName = "C";
-            else if(runNumber < 303435) jecName = "D";
-            else if(runNumber < 304911) jecName = "E";
-            else if(runNumber < 306464) jecName = "F";
-            else{
-                jecName = "GH";
-                std::cerr << "no JEC available for 2017 runs G-H, they are not 13 TeV data! Seems like JSON file is not applied" << std::endl;
-            }
-            jecName += version2017;
-        } else {
-            if (runNumber < 271658){
-                jecName = "A";
-                std::cerr << "no JEC available for 2016 run A, seems like JSON file is not applied!" << std::endl;
-            }
-            else if(runNumber < 276812) jecName = "BCD";
-            else if(runNumber < 278809) jecName = "EF";
-            else if(runNumber < 294645) jecName = "GH";
-            jecName += version2016;
+        for(const EraRange& range : (is2018 ? eras2018 : (is2017 ? eras2017 : eras2016))){
+            eras.push_back({range.firstRun, campaign + range.runName + version + "_DATA", range.warning});
         }
-        return (jecName + "_DATA");
-    } else{
-        if(is2018)      jecName = version2018;
-        else if(is2017) jecName = version2017;
-        else            jecName = version2016;
-        return (jecName + "_MC");
+    } else {
+        eras.push_back({0, campaign + version + "_MC", ""});
     }
 }
 
-std::string JEC::getJECName(const unsigned long runNumber){
-    if(is2018)      return "Fall17_17Nov2017" + getJECRunName(runNumber); //TODO
-    else if(is2017) return "Fall17_17Nov2017" + getJECRunName(runNumber);
-    else            return "Summer16_07Aug2017" + getJECRunName(runNumber);
+JEC::~JEC(){}
+
+void JEC::updateJEC(const unsigned long runNumber){
+    auto era = std::upper_bound(eras.begin(), eras.end(), runNumber, [](const unsigned long run, const Era& e){ return run < e.firstRun; }) - 1;
+    if(&*era == currentEra) return;
+
+    if(!era->warning.empty()) std::cerr << era->warning << std::endl;
+    if(era->jetCorrectionLevels.empty()) setJEC(*era);
+    currentEra = &*era;
+}
+
+void JEC::setJEC(Era& era){
+    std::vector<JetCorrectionTable> levels;
+    levels.emplace_back(JetCorrectorParameters( path + era.name + "_L1FastJet_AK4PFchs.txt") );
+    levels.emplace_back(JetCorrectorParameters( path + era.name + "_L2Relative_AK4PFchs.txt") );
+    levels.emplace_back(JetCorrectorParameters( path + era.name + "_L3Absolute_AK4PFchs.txt") );
+    if(isData) levels.emplace_back(JetCorrectorParameters( path + era.name + "_L2L3Residual_AK4PFchs.txt") );
+    era.jetUncertainties.reset(new JetCorrectionUncertainty(path + era.name + "_Uncertainty_AK4PFchs.txt") );
+    era.jetCorrectionLevels = std::move(levels);
 }
 
-std::vector<float> JEC::getSubCorrections(double rawPt, double eta, double rho, double area){
-    jetCorrector->setJetEta(eta);
-    jetCorrector->setRho(rho);
-    jetCorrector->setJetA(area);
-    jetCorrector->setJetPt(rawPt); 
-    std::vector< float > corrections = jetCorrector->getSubCorrections();
+/*
+ * Same sequence as FactorizedJetCorrector::getSubCorrections: every level is evaluated at the pt corrected by the previous levels,
+ * in single precision, and the cumulative factors are returned (the last level is repeated when there is no L2L3Residual)
+ */
+JEC::SubCorrections JEC::getSubCorrections(double rawPt, double eta, double rho, double area) const{
+    float variables[JetCorrectionTable::nVariables];
+    variables[JetCorrectionTable::jetEta] = eta;
+    variables[JetCorrectionTable::jetPt]  = rawPt;
+    variables[JetCorrectionTable::jetA]   = area;
+    variables[JetCorrectionTable::rho]    = rho;
+
+    SubCorrections corrections;
+    float factor = 1.;
+    for(unsigned level = 0; level < nLevels; ++level){
+        if(level < currentEra->jetCorrectionLevels.size()){
+            float scale = currentEra->jetCorrectionLevels[level].correction(variables);
+            factor                               *= scale;
+            variables[JetCorrectionTable::jetPt] *= scale;
+        }
+        corrections[level] = factor;
+    }
     return corrections;
 }
 
-double JEC::jetCorrection(double rawPt, double eta, double rho, double area, const std::string& level){
-
-    std::vector< float > corrections = getSubCorrections(rawPt, eta, rho, area); 
+double JEC::jetCorrection(double rawPt, double eta, double rho, double area, const Level level){
+    return getSubCorrections(rawPt, eta, rho, area)[level];
+}
 
-    if (level == "L1FastJet")    return corrections.front();
-    if (level == "L2Relative")   return corrections[1];
-    if (level == "L2L3Residual") return corrections.back();
-    return corrections[2];
+void JEC::jetCorrections(const std::vector<pat::Jet>& jets, const double rho, std::vector<SubCorrections>& corrections) const{
+    corrections.resize(jets.size());
+    for(unsigned j = 0; j < jets.size(); ++j){
+        const auto rawP4 = jets[j].correctedP4("Uncorrected");
+        corrections[j]   = getSubCorrections(rawP4.pt(), rawP4.eta(), rho, jets[j].jetArea());
+    }
 }
 
 
 double JEC::jetUncertainty(double pt, double eta){
     if(eta> 5.0) eta = 5.0;
     else if (eta<-5.0) eta =-5.0;
-    jetUncertainties->setJetPt(pt);
-    jetUncertainties->setJetEta(eta);
-    return jetUncertainties->getUncertainty(true);
+    currentEra->jetUncertainties->setJetPt(pt);
+    currentEra->jetUncertainties->setJetEta(eta);
+    return currentEra->jetUncertainties->getUncertainty(true);
 }
 
 
 std::pair<double, double> JEC::getMETCorrectionPxPy(double rawPt, double rawEta, double rawMuonSubtractedPt, double phi, double emf, double rho, double area){
 
-    std::vector< float > corrections = getSubCorrections(rawPt, rawEta, rho, area); 
+    SubCorrections corrections = getSubCorrections(rawPt, rawEta, rho, area);
 
-    double l1corrpt   = rawMuonSubtractedPt*corrections.front(); // l1fastjet corrections were pushed pack first
-    double fullcorrpt = rawMuonSubtractedPt*corrections.back();  // full corrections are the last in the vector
+    double l1corrpt   = rawMuonSubtractedPt*corrections[L1FastJet];
+    double fullcorrpt = rawMuonSubtractedPt*corrections[L2L3Residual]; // full corrections, L3Absolute for MC
     // the corretions for the MET are the difference between l1fastjet and the full corrections on the jet!
     if(emf > 0.9 or fullcorrpt < 15. || (fabs(rawEta) > 9.9) ) return {0., 0.}; // skip jets with EMF > 0.9
     
@@ -1,12 +1,18 @@
 #include "heavyNeutrino/multilep/interface/JetAnalyzer.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
-#include "DataFormats/Math/interface/deltaR.h"
 
 //include c++ library classes
 #include <algorithm>
 
+namespace {
+    enum BTagDiscriminator {csvV2, deepCsvUdsg, deepCsvB, deepCsvC, deepCsvBB};                                //read through a PatLabelIndex, in the order of the label list
+    const std::vector<std::string> bTagLabels = {"pfCombinedInclusiveSecondaryVertexV2BJetTags",
+        "pfDeepCSVJetTags:probudsg", "pfDeepCSVJetTags:probb", "pfDeepCSVJetTags:probc", "pfDeepCSVJetTags:probbb"};
+}
+
 JetAnalyzer::JetAnalyzer(const edm::ParameterSet& iConfig, multilep* multilepAnalyzer):
-    multilepAnalyzer(multilepAnalyzer)
+    multilepAnalyzer(multilepAnalyzer),
+    bTagDiscriminators(bTagLabels, PatLabelIndex::lastOrDefault)
 {
     std::string jecFile;
     if(multilepAnalyzer->is2018)      jecFile = "jecUncertaintyFile17"; // TODO: update when 2018 JEC become available
@@ -14,10 +20,21 @@ JetAnalyzer::JetAnalyzer(const edm::ParameterSet& iConfig, multilep* multilepAna
     else                              jecFile = "jecUncertaintyFile16";
 
     jecUnc = new JetCorrectionUncertainty((iConfig.getParameter<edm::FileInPath>(jecFile)).fullPath());
+
+    //split JEC uncertainties, all requested sources are evaluated together
+    std::vector<std::string> sources = iConfig.getParameter<std::vector<std::string>>("jecUncertaintySources");
+    if(!sources.empty()){
+        jecSources = new JetUncertaintySources((iConfig.getParameter<edm::FileInPath>(jecFile + "Sources")).fullPath(), sources);
+        _jetPt_JECSourceUp.resize(sources.size());
+        _jetPt_JECSourceDown.resize(sources.size());
+        jecSourceUp.resize(sources.size());
+        jecSourceDown.resize(sources.size());
+    }
 };
 
 JetAnalyzer::~JetAnalyzer(){
     delete jecUnc;
+    delete jecSources;
 }
 
 // Note that here only the uncertainty is saved, the Up and Down variations still need to be calculated later, probably easier to do on python level
@@ -29,6 +46,11 @@ void JetAnalyzer::beginJob(TTree* outputTree){
     outputTree->Branch("_jetPt",                     &_jetPt,                    "_jetPt[_nJets]/D");
     outputTree->Branch("_jetPt_JECDown",             &_jetPt_JECDown,            "_jetPt_JECDown[_nJets]/D");
     outputTree->Branch("_jetPt_JECUp",               &_jetPt_JECUp,              "_jetPt_JECUp[_nJets]/D");
+    for(unsigned s = 0; jecSources and s < jecSources->size(); ++s){
+        std::string name = "_jetPt_JEC" + jecSources->source(s);
+        outputTree->Branch((name + "Down").c_str(),  _jetPt_JECSourceDown[s].data(), (name + "Down[_nJets]/D").c_str());
+        outputTree->Branch((name + "Up").c_str(),    _jetPt_JECSourceUp[s].data(),   (name + "Up[_nJets]/D").c_str());
+    }
     outputTree->Branch("_jetSmearedPt",              &_jetSmearedPt,             "_jetSmearedPt[_nJets]/D");
     outputTree->Branch("_jetSmearedPt_JECDown",      &_jetSmearedPt_JECDown,     "_jetSmearedPt_JECDown[_nJets]/D");
     outputTree->Branch("_jetSmearedPt_JECUp",        &_jetSmearedPt_JECUp,       "_jetSmearedPt_JECUp[_nJets]/D");
@@ -78,18 +100,24 @@ void JetAnalyzer::beginJob(TTree* outputTree){
 
 bool JetAnalyzer::analyze(const edm::Event& iEvent){
     edm::Handle<std::vector<pat::Jet>> jets;            iEvent.getByToken(multilepAnalyzer->jetToken,            jets);
-    edm::Handle<std::vector<pat::Jet>> jetsSmeared;     iEvent.getByToken(multilepAnalyzer->jetSmearedToken,     jetsSmeared);
-    edm::Handle<std::vector<pat::Jet>> jetsSmearedUp;   iEvent.getByToken(multilepAnalyzer->jetSmearedUpToken,   jetsSmearedUp);
-    edm::Handle<std::vector<pat::Jet>> jetsSmearedDown; iEvent.getByToken(multilepAnalyzer->jetSmearedDownToken, jetsSmearedDown);
     edm::Handle<std::vector<pat::MET>> mets;            iEvent.getByToken(multilepAnalyzer->metToken, mets);
 
+    //smeared pt for the nominal, up and down JER variations, keyed to the jets (no smearing on data)
+    edm::Handle<edm::ValueMap<double>> jetsSmearedPt, jetsSmearedPtUp, jetsSmearedPtDown;
+    if(!multilepAnalyzer->isData){
+        iEvent.getByToken(multilepAnalyzer->jetSmearedPtToken,     jetsSmearedPt);
+        iEvent.getByToken(multilepAnalyzer->jetSmearedPtUpToken,   jetsSmearedPtUp);
+        iEvent.getByToken(multilepAnalyzer->jetSmearedPtDownToken, jetsSmearedPtDown);
+    }
+
     //to apply JEC from txt files
     edm::Handle<double> rho;                            iEvent.getByToken(multilepAnalyzer->rhoToken,            rho);
 
     _nJets = 0;
+    if(!jets->empty()) bTagDiscriminators.validate(jets->front().getPairDiscri());                  // discriminator positions, only resolved again when the layout changed
 
-
-    for(const auto& jet : *jets){
+    for(unsigned j = 0; j < jets->size(); ++j){
+        const pat::Jet& jet = (*jets)[j];
         if(_nJets == nJets_max) break;
 
         //only store loose jets
@@ -98,21 +126,11 @@ bool JetAnalyzer::analyze(const edm::Event& iEvent){
         _jetIsTight[_nJets]        = jetIsTight(jet, multilepAnalyzer->is2017 || multilepAnalyzer->is2018);
         _jetIsTightLepVeto[_nJets] = jetIsTightLepVeto(jet, multilepAnalyzer->is2017 || multilepAnalyzer->is2018);
 
-        //find smeared equivalents of nominal jet
-        auto jetSmearedIt = jetsSmeared->begin();
-        for(auto j = jetsSmeared->cbegin(); j != jetsSmeared->cend(); ++j){
-            if(reco::deltaR(jet, *j) < reco::deltaR(jet, *jetSmearedIt)) jetSmearedIt = j;
-        }
-
-        auto jetSmearedUpIt = jetsSmearedUp->begin();
-        for(auto j = jetsSmearedUp->cbegin(); j != jetsSmearedUp->cend(); ++j){
-            if(reco::deltaR(jet, *j) < reco::deltaR(jet, *jetSmearedUpIt))  jetSmearedUpIt = j;
-        }
-
-        auto jetSmearedDownIt = jetsSmearedDown->begin();
-        for(auto j = jetsSmearedDown->cbegin(); j != jetsSmearedDown->cend(); ++j){
-            if(reco::deltaR(jet, *j) < reco::deltaR(jet, *jetSmearedDownIt))  jetSmearedDownIt = j;
-        }
+        //smeared equivalents of nominal jet, smearing only scales the jet energy so the eta is unchanged
+        const edm::Ref<std::vector<pat::Jet>> jetRef(jets, j);
+        double smearedPt     = multilepAnalyzer->isData ? jet.pt() : (*jetsSmearedPt)[jetRef];
+        double smearedPtUp   = multilepAnalyzer->isData ? jet.pt() : (*jetsSmearedPtUp)[jetRef];
+        double smearedPtDown = multilepAnalyzer->isData ? jet.pt() : (*jetsSmearedPtDown)[jetRef];
 
         //nominal jet pt and uncertainties
         jecUnc->setJetEta(jet.eta());
@@ -124,14 +142,14 @@ bool JetAnalyzer::analyze(const edm::Event& iEvent){
         _jetPt_JECUp[_nJets]   = _jetPt[_nJets]*(1 + unc);
 
         //smeared jet pt and uncertainties
-        jecUnc->setJetEta(jetSmearedIt->eta());
-        jecUnc->setJetPt(jetSmearedIt->pt());
+        jecUnc->setJetEta(jet.eta());
+        jecUnc->setJetPt(smearedPt);
         double uncSmeared = jecUnc->getUncertainty(true);
-        _jetSmearedPt[_nJets]         = jetSmearedIt->pt();
+        _jetSmearedPt[_nJets]         = smearedPt;
         _jetSmearedPt_JECDown[_nJets] = _jetPt[_nJets]*( 1. - uncSmeared );
         _jetSmearedPt_JECUp[_nJets]   = _jetPt[_nJets]*( 1. + uncSmeared );
-        _jetSmearedPt_JERDown[_nJets] = jetSmearedDownIt->pt();
-        _jetSmearedPt_JERUp[_nJets]   = jetSmearedUpIt->pt();
+        _jetSmearedPt_JERDown[_nJets] = smearedPtDown;
+        _jetSmearedPt_JERUp[_nJets]   = smearedPtUp;
 
         //find maximum of all pT variations
         std::vector<double> ptVector = {_jetPt[_nJets], _jetPt_JECDown[_nJets], _jetPt_JECUp[_nJets],
@@ -139,6 +157,14 @@ bool JetAnalyzer::analyze(const edm::Event& iEvent){
         double maxpT = *(std::max_element(ptVector.cbegin(), ptVector.cend()));
         if(maxpT <= 25) continue;
 
+        if(jecSources){
+            jecSources->uncertainties(jet.pt(), jet.eta(), jecSourceUp.data(), jecSourceDown.data());
+            for(unsigned s = 0; s < jecSources->size(); ++s){
+                _jetPt_JECSourceDown[s][_nJets] = _jetPt[_nJets]*(1 - jecSourceDown[s]);
+                _jetPt_JECSourceUp[s][_nJets]   = _jetPt[_nJets]*(1 + jecSourceUp[s]);
+            }
+        }
+
         _jetPt_Uncorrected[_nJets]        = jet.correctedP4("Uncorrected").Pt();
         _jetPt_L1[_nJets]                 = jet.correctedP4("L1FastJet").Pt();
         _jetPt_L2[_nJets]                 = jet.correctedP4("L2Relative").Pt();
@@ -149,12 +175,12 @@ bool JetAnalyzer::analyze(const edm::Event& iEvent){
         _jetE[_nJets]                     = jet.energy();
 
         //Old csvV2 b-tagger
-        _jetCsvV2[_nJets]                 = jet.bDiscriminator("pfCombinedInclusiveSecondaryVertexV2BJetTags");
+        _jetCsvV2[_nJets]                 = bTagDiscriminators.value(jet.getPairDiscri(), csvV2);
         //new DeepFlavour tagger
-        _jetDeepCsv_udsg[_nJets]          = jet.bDiscriminator("pfDeepCSVJetTags:probudsg");
-        _jetDeepCsv_b[_nJets]             = jet.bDiscriminator("pfDeepCSVJetTags:probb");
-        _jetDeepCsv_c[_nJets]             = jet.bDiscriminator("pfDeepCSVJetTags:probc");
-        _jetDeepCsv_bb[_nJets]            = jet.bDiscriminator("pfDeepCSVJetTags:probbb");
+        _jetDeepCsv_udsg[_nJets]          = bTagDiscriminators.value(jet.getPairDiscri(), deepCsvUdsg);
+        _jetDeepCsv_b[_nJets]             = bTagDiscriminators.value(jet.getPairDiscri(), deepCsvB);
+        _jetDeepCsv_c[_nJets]             = bTagDiscriminators.value(jet.getPairDiscri(), deepCsvC);
+        _jetDeepCsv_bb[_nJets]            = bTagDiscriminators.value(jet.getPairDiscri(), deepCsvBB);
         _jetHadronFlavor[_nJets]          = jet.hadronFlavour();
 
         _jetNeutralHadronFraction[_nJets] = jet.neutralHadronEnergyFraction();
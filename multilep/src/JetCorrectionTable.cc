@@ -0,0 +1,79 @@
+#include "heavyNeutrino/multilep/interface/JetCorrectionTable.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <algorithm>
+
+namespace {
+    JetCorrectionTable::Variable variableIndex(const std::string& name){
+        if(name == "JetEta") return JetCorrectionTable::jetEta;
+        if(name == "JetPt")  return JetCorrectionTable::jetPt;
+        if(name == "JetA")   return JetCorrectionTable::jetA;
+        if(name == "Rho")    return JetCorrectionTable::rho;
+        throw cms::Exception("JetCorrectionTable") << "Unsupported jet correction variable " << name;
+    }
+}
+
+JetCorrectionTable::JetCorrectionTable(const JetCorrectorParameters& corrections):
+    formula(corrections.definitions().formula())
+{
+    const JetCorrectorParameters::Definitions& definitions = corrections.definitions();
+    if(definitions.isResponse() or definitions.nBinVar() < 1 or definitions.nBinVar() > 2 or definitions.nParVar() > nVariables){
+        throw cms::Exception("JetCorrectionTable") << "Unsupported jet correction layout for " << definitions.level();
+    }
+    for(unsigned i = 0; i < definitions.nBinVar(); ++i) binVariables.push_back(variableIndex(definitions.binVar(i)));
+    for(unsigned i = 0; i < definitions.nParVar(); ++i) parVariables.push_back(variableIndex(definitions.parVar(i)));
+
+    //records are ordered in the first binning variable, consecutive records with the same range form the bins of the second variable
+    //a few L2Relative files have slightly overlapping pt bins: the lower edge is moved up such that the first matching record is used, as in JetCorrectorParameters::binIndex
+    parameterOffset.push_back(0);
+    for(unsigned r = 0; r < corrections.size(); ++r){
+        const JetCorrectorParameters::Record& record = corrections.record(r);
+        if(etaLow.empty() or record.xMin(0) != etaLow.back() or record.xMax(0) != etaHigh.back()){
+            if(!etaLow.empty() and record.xMin(0) < etaHigh.back()) throw cms::Exception("JetCorrectionTable") << "Unsorted or overlapping bins for " << definitions.level();
+            etaLow.push_back(record.xMin(0));
+            etaHigh.push_back(record.xMax(0));
+            etaFirstBin.push_back(r);
+        } else if(binVariables.size() == 1 or record.xMax(1) <= high.back()){
+            throw cms::Exception("JetCorrectionTable") << "Unsorted or overlapping bins for " << definitions.level();
+        }
+        if(binVariables.size() == 2){
+            bool newEtaBin = (etaFirstBin.back() == r);
+            low.push_back(newEtaBin ? record.xMin(1) : std::max(record.xMin(1), high.back()));
+            high.push_back(record.xMax(1));
+        }
+        for(float parameter : record.parameters()) parameters.push_back(parameter);
+        parameterOffset.push_back(parameters.size());
+    }
+    etaFirstBin.push_back(corrections.size());
+}
+
+
+int JetCorrectionTable::bin(const float* variables) const{
+    const float x = variables[binVariables[0]];
+    int etaBin    = (int) (std::upper_bound(etaLow.cbegin(), etaLow.cend(), x) - etaLow.cbegin()) - 1;
+    if(etaBin < 0 or x >= etaHigh[etaBin]) return -1;
+    if(binVariables.size() == 1)           return etaBin;
+
+    const float y = variables[binVariables[1]];
+    auto first    = low.cbegin() + etaFirstBin[etaBin];
+    auto last     = low.cbegin() + etaFirstBin[etaBin + 1];
+    int b         = (int) (std::upper_bound(first, last, y) - low.cbegin()) - 1;
+    if(b < (int) etaFirstBin[etaBin] or y >= high[b]) return -1;
+    return b;
+}
+
+
+float JetCorrectionTable::correction(const float* variables) const{
+    int b = bin(variables);
+    if(b < 0) return 1.;
+
+    //the first entries of the parameter block are the clamp ranges of the parameter variables, followed by the formula parameters
+    const double* par = parameters.data() + parameterOffset[b];
+    const unsigned nPar = parVariables.size();
+    double x[nVariables];
+    for(unsigned i = 0; i < nPar; ++i){
+        const float value = variables[parVariables[i]];
+        x[i] = (value < par[2*i]) ? par[2*i] : (value > par[2*i+1]) ? par[2*i+1] : value;
+    }
+    return formula.evaluate(reco::formula::ArrayAdaptor(x, nPar), reco::formula::ArrayAdaptor(par + 2*nPar, parameterOffset[b+1] - parameterOffset[b] - 2*nPar));
+}
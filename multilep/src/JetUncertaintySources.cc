@@ -0,0 +1,82 @@
+#include "heavyNeutrino/multilep/interface/JetUncertaintySources.h"
+#include "CondFormats/JetMETObjects/interface/JetCorrectorParameters.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <algorithm>
+
+JetUncertaintySources::JetUncertaintySources(const std::string& fileName, const std::vector<std::string>& sourceList):
+    sources(sourceList)
+{
+    const unsigned nSources = sources.size();
+    for(unsigned s = 0; s < nSources; ++s){
+        JetCorrectorParameters parameters(fileName, sources[s]);
+        if(parameters.definitions().nBinVar() != 1 or parameters.definitions().binVar(0) != "JetEta" or parameters.definitions().parVar(0) != "JetPt"){
+            throw cms::Exception("JetUncertaintySources") << "Unsupported layout for source " << sources[s] << " in " << fileName;
+        }
+
+        //the grid is taken from the first source, the other sources are required to have the same grid
+        if(s == 0){
+            firstPoint.push_back(0);
+            for(unsigned b = 0; b < parameters.size(); ++b){
+                const std::vector<float>& p = parameters.record(b).parameters();
+                if(p.size() % 3 != 0 or p.empty() or (b > 0 and parameters.record(b).xMin(0) < etaHigh.back())){
+                    throw cms::Exception("JetUncertaintySources") << "Unsupported binning for source " << sources[s] << " in " << fileName;
+                }
+                etaLow.push_back(parameters.record(b).xMin(0));
+                etaHigh.push_back(parameters.record(b).xMax(0));
+                for(unsigned i = 0; i < p.size(); i += 3) ptGrid.push_back(p[i]);
+                firstPoint.push_back(ptGrid.size());
+            }
+            values.resize(2*nSources*ptGrid.size());
+        }
+
+        bool sameGrid = (parameters.size() == etaLow.size());
+        for(unsigned b = 0; sameGrid and b < parameters.size(); ++b){
+            const std::vector<float>& p = parameters.record(b).parameters();
+            sameGrid = parameters.record(b).xMin(0) == etaLow[b] and parameters.record(b).xMax(0) == etaHigh[b] and p.size() == 3*(firstPoint[b+1] - firstPoint[b]);
+            for(unsigned point = firstPoint[b]; sameGrid and point < firstPoint[b+1]; ++point){
+                const unsigned i = 3*(point - firstPoint[b]);
+                sameGrid = (p[i] == ptGrid[point]);
+                values[(2*point)*nSources + s]   = p[i+1];
+                values[(2*point+1)*nSources + s] = p[i+2];
+            }
+        }
+        if(!sameGrid) throw cms::Exception("JetUncertaintySources") << "Source " << sources[s] << " in " << fileName << " does not share the binning of " << sources[0];
+    }
+}
+
+
+void JetUncertaintySources::uncertainties(const float pt, const float eta, float* up, float* down) const{
+    const unsigned nSources = sources.size();
+    int etaBin = (int) (std::upper_bound(etaLow.cbegin(), etaLow.cend(), eta) - etaLow.cbegin()) - 1;
+    if(etaBin < 0 or eta >= etaHigh[etaBin]){
+        std::fill(up,   up + nSources,   -999.);
+        std::fill(down, down + nSources, -999.);
+        return;
+    }
+
+    //constant outside the pt grid
+    const unsigned first = firstPoint[etaBin];
+    const unsigned last  = firstPoint[etaBin + 1] - 1;
+    if(pt <= ptGrid[first] or pt >= ptGrid[last]){
+        const float* v = values.data() + 2*nSources*(pt <= ptGrid[first] ? first : last);
+        std::copy(v,            v + nSources,   up);
+        std::copy(v + nSources, v + 2*nSources, down);
+        return;
+    }
+
+    //linear interpolation written as in SimpleJetCorrectionUncertainty, such that the results are identical
+    const unsigned point = (std::upper_bound(ptGrid.cbegin() + first, ptGrid.cbegin() + last + 1, pt) - ptGrid.cbegin()) - 1;
+    const float x0 = ptGrid[point];
+    const float x1 = ptGrid[point + 1];
+    auto interpolate = [&](const float* y0, const float* y1, float* result){
+        for(unsigned s = 0; s < nSources; ++s){
+            float a   = (y1[s] - y0[s])/(x1 - x0);
+            float b   = (y0[s]*x1 - y1[s]*x0)/(x1 - x0);
+            result[s] = a*pt + b;
+        }
+    };
+    const float* v = values.data() + 2*nSources*point;
+    interpolate(v,            v + 2*nSources, up);
+    interpolate(v + nSources, v + 3*nSources, down);
+}
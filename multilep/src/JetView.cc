@@ -0,0 +1,108 @@
+#include "heavyNeutrino/multilep/interface/JetView.h"
+#include "DataFormats/Math/interface/deltaR.h"
+#include "DataFormats/PatCandidates/interface/PackedCandidate.h"
+
+#include "TMath.h"
+#include "TVector2.h"
+
+#include <cmath>
+
+namespace {
+    enum BTagDiscriminator {csvV2Tag, deepCsvBTag, deepCsvBBTag};                                        //read through a PatLabelIndex, in the order of the label list
+    const std::vector<std::string> bTagLabels = {"pfCombinedInclusiveSecondaryVertexV2BJetTags", "pfDeepCSVJetTags:probb", "pfDeepCSVJetTags:probbb"};
+}
+
+JetView::JetView():
+    bTagDiscriminators(bTagLabels, PatLabelIndex::lastOrDefault)
+{}
+
+
+void JetView::fill(const std::vector<pat::Jet>& allJets, PackedTrackCache& packedTrackCache){
+    trackCache = &packedTrackCache;
+    jets.clear();
+    for(auto array : {&pts, &etas, &phis})               array->clear();
+    for(auto array : {&p4s, &l1P4s})                     array->clear();
+    for(auto array : {&csvV2s, &deepCsvBs, &deepCsvBBs})  array->clear();
+    deltaRs.clear();
+    trackEtas.clear();
+    trackPhis.clear();
+
+    if(!allJets.empty()) bTagDiscriminators.validate(allJets.front().getPairDiscri());
+    for(const pat::Jet& jet : allJets){
+        if(jet.pt() <= 5 || fabs(jet.eta()) >= 3) continue;
+        jets.push_back(&jet);
+        pts.push_back(jet.pt());
+        etas.push_back(jet.eta());
+        phis.push_back(jet.phi());
+        p4s.push_back(jet.p4());
+        l1P4s.push_back(jet.correctedP4("L1FastJet"));
+        csvV2s.push_back(bTagDiscriminators.value(jet.getPairDiscri(), csvV2Tag));
+        deepCsvBs.push_back(bTagDiscriminators.value(jet.getPairDiscri(), deepCsvBTag));
+        deepCsvBBs.push_back(bTagDiscriminators.value(jet.getPairDiscri(), deepCsvBBTag));
+    }
+    trackBegins.assign(jets.size(), -1);
+    trackEnds.assign(jets.size(), -1);
+}
+
+
+void JetView::associate(const unsigned l, const reco::Candidate& lepton){
+    const unsigned nJets = jets.size();
+    if(deltaRs.size() < (l + 1)*nJets) deltaRs.resize((l + 1)*nJets);
+    const double leptonEta = lepton.eta();
+    const double leptonPhi = lepton.phi();
+    for(unsigned j = 0; j < nJets; ++j) deltaRs[l*nJets + j] = reco::deltaR(etas[j], phis[j], leptonEta, leptonPhi);
+}
+
+
+unsigned JetView::closestJet(const unsigned l) const{
+    unsigned closest = 0;
+    for(unsigned j = 1; j < jets.size(); ++j){
+        if(deltaR(l, j) < deltaR(l, closest)) closest = j;
+    }
+    return closest;
+}
+
+
+/*
+ * Track quality selection on the daughters of jet j, independent of the lepton
+ */
+void JetView::selectTracks(const unsigned j){
+    const pat::Jet& jet = *jets[j];
+    trackBegins[j] = trackEtas.size();
+    for(unsigned d = 0; d < jet.numberOfDaughters(); ++d){
+        const pat::PackedCandidate* daughter = (const pat::PackedCandidate*) jet.daughter(d);
+        if(daughter->hasTrackDetails()){
+            const PackedTrackCache::Track& daughterTrack = trackCache->track(*daughter);
+            if(daughterTrack.pt <= 1)                                   continue;
+            if(daughterTrack.charge == 0)                               continue;
+            if(daughter->fromPV() < 2)                                  continue;
+            if(daughterTrack.numberOfValidHits < 8)                     continue;
+            if(daughterTrack.numberOfValidPixelHits < 2)                continue;
+            if(daughterTrack.normalizedChi2 >= 5)                       continue;
+            if(fabs(daughterTrack.dz) >= 17)                            continue;
+            if(fabs(daughterTrack.dxy) >= 0.2)                          continue;
+
+            TLorentzVector trackVec(daughterTrack.px, daughterTrack.py, daughterTrack.pz, daughterTrack.p);
+            trackEtas.push_back(trackVec.Eta());
+            trackPhis.push_back(trackVec.Phi());
+        }
+    }
+    trackEnds[j] = trackEtas.size();
+}
+
+
+/*
+ * Distance from the lepton-aware jet core, same computation as TLorentzVector::DeltaR
+ */
+unsigned JetView::selectedTrackMult(const unsigned j, const TLorentzVector& lepAwareJet){
+    if(trackBegins[j] < 0) selectTracks(j);
+    const double jetEta = lepAwareJet.Eta();
+    const double jetPhi = lepAwareJet.Phi();
+    unsigned selectedTrackMult = 0;
+    for(int t = trackBegins[j]; t < trackEnds[j]; ++t){
+        double deta = trackEtas[t] - jetEta;
+        double dphi = TVector2::Phi_mpi_pi(trackPhis[t] - jetPhi);
+        if(TMath::Sqrt(deta*deta + dphi*dphi) <= 0.4) ++selectedTrackMult;
+    }
+    return selectedTrackMult;
+}
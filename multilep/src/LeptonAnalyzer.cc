@@ -5,28 +5,56 @@
 #include "TLorentzVector.h"
 #include <algorithm>
 
+namespace {
+    //IDs read through a PatLabelIndex, in the order of the label lists
+    enum ElectronId {cutBasedVeto, cutBasedLoose, cutBasedMedium, cutBasedTight};
+    const std::vector<std::string> electronIdLabels = {
+        "cutBasedElectronID-Fall17-94X-V1-veto", "cutBasedElectronID-Fall17-94X-V1-loose", "cutBasedElectronID-Fall17-94X-V1-medium", "cutBasedElectronID-Fall17-94X-V1-tight"
+    };
+
+    enum TauId {
+        againstMuonLoose3, againstElectronLooseMVA6,
+        byVLooseIsolationMVArun2v1DBoldDMwLT, byLooseIsolationMVArun2v1DBoldDMwLT, byMediumIsolationMVArun2v1DBoldDMwLT, byTightIsolationMVArun2v1DBoldDMwLT, byVTightIsolationMVArun2v1DBoldDMwLT,
+        decayModeFindingNewDMs, byVLooseIsolationMVArun2v1DBnewDMwLT, byLooseIsolationMVArun2v1DBnewDMwLT, byMediumIsolationMVArun2v1DBnewDMwLT, byTightIsolationMVArun2v1DBnewDMwLT, byVTightIsolationMVArun2v1DBnewDMwLT,
+        againstElectronMVA6Raw, byCombinedIsolationDeltaBetaCorrRaw3Hits, byIsolationMVArun2v1PWdR03oldDMwLTraw, byIsolationMVArun2v1DBoldDMwLTraw, byIsolationMVArun2v1DBnewDMwLTraw, byIsolationMVArun2v1PWnewDMwLTraw, byIsolationMVArun2v1PWoldDMwLTraw
+    };
+    const std::vector<std::string> tauIdLabels = {
+        "againstMuonLoose3", "againstElectronLooseMVA6",
+        "byVLooseIsolationMVArun2v1DBoldDMwLT", "byLooseIsolationMVArun2v1DBoldDMwLT", "byMediumIsolationMVArun2v1DBoldDMwLT", "byTightIsolationMVArun2v1DBoldDMwLT", "byVTightIsolationMVArun2v1DBoldDMwLT",
+        "decayModeFindingNewDMs", "byVLooseIsolationMVArun2v1DBnewDMwLT", "byLooseIsolationMVArun2v1DBnewDMwLT", "byMediumIsolationMVArun2v1DBnewDMwLT", "byTightIsolationMVArun2v1DBnewDMwLT", "byVTightIsolationMVArun2v1DBnewDMwLT",
+        "againstElectronMVA6Raw", "byCombinedIsolationDeltaBetaCorrRaw3Hits", "byIsolationMVArun2v1PWdR03oldDMwLTraw", "byIsolationMVArun2v1DBoldDMwLTraw", "byIsolationMVArun2v1DBnewDMwLTraw", "byIsolationMVArun2v1PWnewDMwLTraw", "byIsolationMVArun2v1PWoldDMwLTraw"
+    };
+}
+
 // TODO: we should maybe stop indentifying effective areas by year, as they are typically more connected to a specific ID than to a specific year
-LeptonAnalyzer::LeptonAnalyzer(const edm::ParameterSet& iConfig, multilep* multilepAnalyzer):
+LeptonAnalyzer::LeptonAnalyzer(const edm::ParameterSet& iConfig, multilep* multilepAnalyzer, const LeptonMvaHelpers& leptonMvaHelpers):
     multilepAnalyzer(multilepAnalyzer),
     electronsEffectiveAreas(iConfig.getParameter<edm::FileInPath>("electronsEffectiveAreas").fullPath()),
-    muonsEffectiveAreas    ((multilepAnalyzer->is2017 || multilepAnalyzer->is2018)? (iConfig.getParameter<edm::FileInPath>("muonsEffectiveAreasFall17")).fullPath() : (iConfig.getParameter<edm::FileInPath>("muonsEffectiveAreas")).fullPath() )
+    muonsEffectiveAreas    ((multilepAnalyzer->is2017 || multilepAnalyzer->is2018)? (iConfig.getParameter<edm::FileInPath>("muonsEffectiveAreasFall17")).fullPath() : (iConfig.getParameter<edm::FileInPath>("muonsEffectiveAreas")).fullPath() ),
+    electronIds(electronIdLabels),
+    tauIds(tauIdLabels)
 {
-    leptonMvaComputerSUSY16   = new LeptonMvaHelper(iConfig, 0, false); // SUSY         // TODO: all of these really needed? could use some clean-up
-    leptonMvaComputerTTH16    = new LeptonMvaHelper(iConfig, 1, false); // TTH
-    leptonMvaComputerSUSY17   = new LeptonMvaHelper(iConfig, 0, true);  // SUSY
-    leptonMvaComputerTTH17    = new LeptonMvaHelper(iConfig, 1, true);  // TTH
-    leptonMvaComputertZqTTV16 = new LeptonMvaHelper(iConfig, 2, false); // tZq/TTV
-    leptonMvaComputertZqTTV17 = new LeptonMvaHelper(iConfig, 2, true);  // tZq/TTV
-};
+    leptonMvas = {{"SUSY16",   _leptonMvaSUSY16},   {"TTH16",    _leptonMvaTTH16},
+                  {"SUSY17",   _leptonMvaSUSY17},   {"TTH17",    _leptonMvaTTH17},
+                  {"tZqTTV16", _leptonMvatZqTTV16}, {"tZqTTV17", _leptonMvatZqTTV17}};
+
+    const std::vector<std::string> storedLeptonMvas = iConfig.getParameter<std::vector<std::string>>("leptonMvas");
+    for(LeptonMva& mva : leptonMvas){
+        mva.stored  = std::find(storedLeptonMvas.begin(), storedLeptonMvas.end(), mva.name) != storedLeptonMvas.end();
+        auto helper = leptonMvaHelpers.find(mva.name);
+        if(helper != leptonMvaHelpers.end()) mva.helper = helper->second;
+    }
 
-LeptonAnalyzer::~LeptonAnalyzer(){
-    delete leptonMvaComputerSUSY16;
-    delete leptonMvaComputerTTH16;
-    delete leptonMvaComputertZqTTV16;
-    delete leptonMvaComputerSUSY17;
-    delete leptonMvaComputerTTH17;
-    delete leptonMvaComputertZqTTV17;
-}
+    const edm::ParameterSet leptonIds = iConfig.getParameter<edm::ParameterSet>("leptonIds");
+    const std::string leptonIdNames[nLeptonIds] = {"hnLoose", "hnFO", "hnTight", "ewkLoose", "ewkFO", "ewkTight"};
+    bool* const       flags[nLeptonIds]         = {_lHNLoose, _lHNFO, _lHNTight, _lEwkLoose, _lEwkFO, _lEwkTight};
+    for(unsigned id = 0; id < nLeptonIds; ++id){
+        const edm::ParameterSet workingPoint = leptonIds.getParameter<edm::ParameterSet>(leptonIdNames[id]);
+        muonIdCuts[id]     = readLeptonIdCuts(workingPoint.getParameter<edm::ParameterSet>("muon"));
+        electronIdCuts[id] = readLeptonIdCuts(workingPoint.getParameter<edm::ParameterSet>("electron"));
+        leptonIdFlags[id]  = flags[id];
+    }
+};
 
 void LeptonAnalyzer::beginJob(TTree* outputTree){
     outputTree->Branch("_nL",                           &_nL,                           "_nL/b");
@@ -54,12 +82,9 @@ void LeptonAnalyzer::beginJob(TTree* outputTree){
     outputTree->Branch("_lElectronPassConvVeto",        &_lElectronPassConvVeto,        "_lElectronPassConvVeto[_nLight]/O");
     outputTree->Branch("_lElectronChargeConst",         &_lElectronChargeConst,         "_lElectronChargeConst[_nLight]/O");
     outputTree->Branch("_lElectronMissingHits",         &_lElectronMissingHits,         "_lElectronMissingHits[_nLight]/i");
-    outputTree->Branch("_leptonMvaSUSY16",              &_leptonMvaSUSY16,              "_leptonMvaSUSY16[_nLight]/D");
-    outputTree->Branch("_leptonMvaTTH16",               &_leptonMvaTTH16,               "_leptonMvaTTH16[_nLight]/D");
-    outputTree->Branch("_leptonMvaSUSY17",              &_leptonMvaSUSY17,              "_leptonMvaSUSY17[_nLight]/D");
-    outputTree->Branch("_leptonMvaTTH17",               &_leptonMvaTTH17,               "_leptonMvaTTH17[_nLight]/D");
-    outputTree->Branch("_leptonMvatZqTTV16",            &_leptonMvatZqTTV16,            "_leptonMvatZqTTV16[_nLight]/D");
-    outputTree->Branch("_leptonMvatZqTTV17",            &_leptonMvatZqTTV17,            "_leptonMvatZqTTV17[_nLight]/D");
+    for(const LeptonMva& mva : leptonMvas){
+        if(mva.stored) outputTree->Branch(("_leptonMva" + mva.name).c_str(), mva.values, ("_leptonMva" + mva.name + "[_nLight]/D").c_str());
+    }
     outputTree->Branch("_lHNLoose",                     &_lHNLoose,                     "_lHNLoose[_nLight]/O");
     outputTree->Branch("_lHNFO",                        &_lHNFO,                        "_lHNFO[_nLight]/O");
     outputTree->Branch("_lHNTight",                     &_lHNTight,                     "_lHNTight[_nLight]/O");
@@ -122,14 +147,77 @@ void LeptonAnalyzer::beginJob(TTree* outputTree){
     }
 }
 
-bool LeptonAnalyzer::analyze(const edm::Event& iEvent, const reco::Vertex& primaryVertex){
+/*
+ * Selection phase: count the preselected leptons to decide on the lepton skims
+ * Skipping all isolation, MVA, gen and jet variables, such that events failing the skim are cheap to reject
+ */
+bool LeptonAnalyzer::passSkim(const edm::Event& iEvent, const reco::Vertex& primaryVertex) const{
+    unsigned minLeptons = 0;
+    unsigned minLight   = 0;
+    if(multilepAnalyzer->skim == "trilep")    minLeptons = 3;
+    if(multilepAnalyzer->skim == "dilep")     minLeptons = 2;
+    if(multilepAnalyzer->skim == "ttg")       minLight   = 2;
+    if(multilepAnalyzer->skim == "singlelep") minLeptons = 1;
+    if(multilepAnalyzer->skim == "FR")        minLight   = 1;
+    if(minLeptons == 0 and minLight == 0) return true;
+
+    edm::Handle<std::vector<pat::Electron>> electrons;               iEvent.getByToken(multilepAnalyzer->eleToken,                          electrons);
+    edm::Handle<std::vector<pat::Muon>> muons;                       iEvent.getByToken(multilepAnalyzer->muonToken,                         muons);
+
+    unsigned nLeptons = 0;
+    unsigned minCount = std::max(minLeptons, minLight);
+    for(const pat::Muon& mu : *muons){
+        if(isPreselected(mu, primaryVertex) and ++nLeptons >= minCount) return true;
+    }
+    for(const pat::Electron& ele : *electrons){
+        if(isPreselected(ele, primaryVertex) and ++nLeptons >= minCount) return true;
+    }
+    if(minLight > 0) return false;
+
+    edm::Handle<std::vector<pat::Tau>> taus;                         iEvent.getByToken(multilepAnalyzer->tauToken,                          taus);
+    for(const pat::Tau& tau : *taus){
+        if(isPreselected(tau, primaryVertex) and ++nLeptons >= minCount) return true;
+    }
+    return false;
+}
+
+bool LeptonAnalyzer::isPreselected(const pat::Muon& mu, const reco::Vertex& vertex) const{
+    if(mu.innerTrack().isNull())                                   return false;
+    if(mu.pt() < 5)                                                return false;
+    if(fabs(mu.eta()) > 2.4)                                       return false;
+    if(!mu.isPFMuon())                                             return false;
+    if(!(mu.isTrackerMuon() || mu.isGlobalMuon()))                 return false;
+    if(fabs(mu.innerTrack()->dxy(vertex.position())) > 0.05)       return false;
+    if(fabs(mu.innerTrack()->dz(vertex.position())) > 0.1)         return false;
+    return true;
+}
+
+bool LeptonAnalyzer::isPreselected(const pat::Electron& ele, const reco::Vertex& vertex) const{
+    if(ele.gsfTrack().isNull())                                                                   return false;
+    if(ele.pt() < 7)                                                                              return false;
+    if(fabs(ele.eta()) > 2.5)                                                                     return false;
+    if(ele.gsfTrack()->hitPattern().numberOfLostHits(reco::HitPattern::MISSING_INNER_HITS) > 2)   return false;
+    if(fabs(ele.gsfTrack()->dxy(vertex.position())) > 0.05)                                       return false;
+    if(fabs(ele.gsfTrack()->dz(vertex.position())) > 0.1)                                         return false;
+    return true;
+}
+
+bool LeptonAnalyzer::isPreselected(const pat::Tau& tau, const reco::Vertex& vertex) const{
+    if(tau.pt() < 20)                                              return false;          // Minimum pt for tau reconstruction
+    if(fabs(tau.eta()) > 2.3)                                      return false;
+    //if(!tau.tauID("decayModeFinding"))                           return false;
+    if(tau_dz(tau, vertex.position()) < 0.4)                       return false;          //tau dz cut used in ewkino  --> is this a standard cut? reference?
+    return true;
+}
+
+/*
+ * Fill phase: all lepton variables, only run for events passing the skim
+ */
+void LeptonAnalyzer::analyze(const edm::Event& iEvent, const reco::Vertex& primaryVertex){
     edm::Handle<std::vector<pat::Electron>> electrons;               iEvent.getByToken(multilepAnalyzer->eleToken,                          electrons);
     edm::Handle<std::vector<pat::Muon>> muons;                       iEvent.getByToken(multilepAnalyzer->muonToken,                         muons);
     edm::Handle<std::vector<pat::Tau>> taus;                         iEvent.getByToken(multilepAnalyzer->tauToken,                          taus);
-    edm::Handle<std::vector<pat::PackedCandidate>> packedCands;      iEvent.getByToken(multilepAnalyzer->packedCandidatesToken,             packedCands);
     edm::Handle<double> rho;                                         iEvent.getByToken(multilepAnalyzer->rhoToken,                          rho);
-    edm::Handle<std::vector<pat::Jet>> jets;                         iEvent.getByToken(multilepAnalyzer->jetToken,                          jets);
-  //edm::Handle<std::vector<pat::Jet>> jets;                         iEvent.getByToken(multilepAnalyzer->jetSmearedToken,                   jets);  // Are we sure we do not want the smeared jets here???
     edm::Handle<std::vector<reco::GenParticle>> genParticles;        iEvent.getByToken(multilepAnalyzer->genParticleToken,                  genParticles);
 
     _nL     = 0;
@@ -138,21 +226,20 @@ bool LeptonAnalyzer::analyze(const edm::Event& iEvent, const reco::Vertex& prima
     _nEle   = 0;
     _nTau   = 0;
 
+    muonMvaFeatures.clear();
+    electronMvaFeatures.clear();
+    if(!electrons->empty()) electronIds.validate(electrons->front().electronIDs());                 // ID positions, only resolved again when the layout changed
+    if(!taus->empty())      tauIds.validate(taus->front().tauIDs());
+
     // loop over muons
     // muons need to be run first, because some ID's need to calculate a muon veto for electrons
     for(const pat::Muon& mu : *muons){
         if(_nL == nL_max)                              break;
-        if(mu.innerTrack().isNull())                   continue;
-        if(mu.pt() < 5)                                continue;
-        if(fabs(mu.eta()) > 2.4)                       continue;
-        if(!mu.isPFMuon())                             continue;
-        if(!(mu.isTrackerMuon() || mu.isGlobalMuon())) continue;
+        if(!isPreselected(mu, primaryVertex))          continue;
         fillLeptonImpactParameters(mu, primaryVertex);
-        if(fabs(_dxy[_nL]) > 0.05)                     continue;
-        if(fabs(_dz[_nL]) > 0.1)                       continue;
         fillLeptonKinVars(mu);
         if(!multilepAnalyzer->isData) fillLeptonGenVars(mu, *genParticles);
-        fillLeptonJetVariables(mu, jets, primaryVertex, *rho);
+        fillLeptonJetVariables(mu);
 
         _lFlavor[_nL]        = 1;
         _lMuonSegComp[_nL]    = mu.segmentCompatibility();
@@ -162,12 +249,14 @@ bool LeptonAnalyzer::analyze(const edm::Event& iEvent, const reco::Vertex& prima
         _relIso[_nL]         = getRelIso03(mu, *rho);                     // Isolation variables
         _relIso0p4[_nL]      = getRelIso04(mu, *rho);
         _relIso0p4MuDeltaBeta[_nL] = getRelIso04(mu, *rho, true);
-        _miniIso[_nL]        = getMiniIsolation(mu, packedCands, 0.05, 0.2, 10, *rho, false); // TODO: check how this compares with the MiniIsoLoose,etc... booleans
-        _miniIsoCharged[_nL] = getMiniIsolation(mu, packedCands, 0.05, 0.2, 10, *rho, true);
+        double miniIsoCone   = getMiniIsoConeSize(mu, 0.05, 0.2, 10);
+        IsolationSums miniIsoSums;
+        getIsolationSums(mu, &miniIsoCone, &miniIsoSums, 1);
+        _miniIso[_nL]        = getRelIso(mu, miniIsoSums, miniIsoCone, *rho, false);      // TODO: check how this compares with the MiniIsoLoose,etc... booleans
+        _miniIsoCharged[_nL] = getRelIso(mu, miniIsoSums, miniIsoCone, *rho, true);
 
-        _lHNLoose[_nL]       = isHNLoose(mu);                                                       // ID variables
-        _lHNFO[_nL]          = isHNFO(mu);                                                          // don't change order, they rely on above variables
-        _lHNTight[_nL]       = isHNTight(mu);
+        _lMuonIsLoose[_nL]   = mu.isLooseMuon();                                                    // ID variables, the HN and ewkino ids are evaluated after the loop
+        _lMuonIsMedium[_nL]  = mu.isMediumMuon();
 
         _lPOGVeto[_nL]       = mu.passed(reco::Muon::CutBasedIdLoose); // no veto available, so we take loose here
         _lPOGLoose[_nL]      = mu.passed(reco::Muon::CutBasedIdLoose);
@@ -175,88 +264,69 @@ bool LeptonAnalyzer::analyze(const edm::Event& iEvent, const reco::Vertex& prima
         _lPOGTight[_nL]      = mu.passed(reco::Muon::CutBasedIdTight);
         // TODO: consider to add muon MVA
 
-        _leptonMvaSUSY16[_nL]  = leptonMvaVal(mu, leptonMvaComputerSUSY16);
-        _leptonMvaTTH16[_nL]   = leptonMvaVal(mu, leptonMvaComputerTTH16);
-        _leptonMvaSUSY17[_nL]  = leptonMvaVal(mu, leptonMvaComputerSUSY17);
-        _leptonMvaTTH17[_nL]   = leptonMvaVal(mu, leptonMvaComputerTTH17);
-        _leptonMvatZqTTV16[_nL] = leptonMvaVal(mu, leptonMvaComputertZqTTV16);
-        _leptonMvatZqTTV17[_nL] = leptonMvaVal(mu, leptonMvaComputertZqTTV17);
-
-        _lEwkLoose[_nL]      = isEwkLoose(mu);
-        _lEwkFO[_nL]         = isEwkFO(mu);
-        _lEwkTight[_nL]      = isEwkTight(mu);
+        fillLeptonMvaFeatures(mu);                                                                   // lepton MVAs are evaluated for all muons at once after the loop
 
         ++_nMu;
         ++_nL;
         ++_nLight;
     }
 
+    computeLeptonMvas(muonMvaFeatures, 0, true);
+    computeLeptonIds(0, _nMu, false);                                                                // ewkino FO and tight depend on the lepton MVA
+
     // Loop over electrons (note: using iterator we can easily get the ref too)
     for(auto ele = electrons->begin(); ele != electrons->end(); ++ele){
         if(_nL == nL_max)                                                                               break;
-        if(ele->gsfTrack().isNull())                                                                    continue;
-        if(ele->pt() < 7)                                                                               continue;
-        if(fabs(ele->eta()) > 2.5)                                                                      continue;
-        if(ele->gsfTrack()->hitPattern().numberOfLostHits(reco::HitPattern::MISSING_INNER_HITS) > 2)    continue;
+        if(!isPreselected(*ele, primaryVertex))                                                         continue;
         fillLeptonImpactParameters(*ele, primaryVertex);
-        if(fabs(_dxy[_nL]) > 0.05)                                                                      continue;
-        if(fabs(_dz[_nL]) > 0.1)                                                                        continue;
         fillLeptonKinVars(*ele);
         if(!multilepAnalyzer->isData) fillLeptonGenVars(*ele, *genParticles);
-        fillLeptonJetVariables(*ele, jets, primaryVertex, *rho);
+        fillLeptonJetVariables(*ele);
 
         _lFlavor[_nL]                   = 0;
         _lEtaSC[_nL]                    = ele->superCluster()->eta();
 
         _relIso[_nL]                    = getRelIso03(*ele, *rho);
-        _relIso0p4[_nL]                 = getRelIso(*ele, packedCands, 0.4, *rho, false);
-        _miniIso[_nL]                   = getMiniIsolation(*ele, packedCands, 0.05, 0.2, 10, *rho, false);
-        _miniIsoCharged[_nL]            = getMiniIsolation(*ele, packedCands, 0.05, 0.2, 10, *rho, true);
+        double isoCones[2] = {0.4, getMiniIsoConeSize(*ele, 0.05, 0.2, 10)};                       // 0.4 and mini-isolation cone in one pass
+        IsolationSums isoSums[2];
+        getIsolationSums(*ele, isoCones, isoSums, 2);
+        _relIso0p4[_nL]                 = getRelIso(*ele, isoSums[0], isoCones[0], *rho, false);
+        _miniIso[_nL]                   = getRelIso(*ele, isoSums[1], isoCones[1], *rho, false);
+        _miniIsoCharged[_nL]            = getRelIso(*ele, isoSums[1], isoCones[1], *rho, true);
         _lElectronMvaSummer16GP[_nL]    = ele->userFloat("ElectronMVAEstimatorRun2Spring16GeneralPurposeV1Values"); // OLD, do not use it
         _lElectronMvaSummer16HZZ[_nL]   = ele->userFloat("ElectronMVAEstimatorRun2Spring16HZZV1Values"); // OLD, do not use it
         _lElectronMvaFall17v1NoIso[_nL] = ele->userFloat("ElectronMVAEstimatorRun2Fall17NoIsoV1Values"); // OLD, do not use it
         _lElectronMvaFall17Iso[_nL]     = ele->userFloat("ElectronMVAEstimatorRun2Fall17IsoV2Values");
         _lElectronMvaFall17NoIso[_nL]   = ele->userFloat("ElectronMVAEstimatorRun2Fall17NoIsoV2Values");
-        _lElectronPassEmu[_nL]          = passTriggerEmulationDoubleEG(&*ele);                             // Keep in mind, this trigger emulation is for 2016 DoubleEG, the SingleEG trigger emulation is different
+        _lElectronPassEmuNoHOverE[_nL]  = passTriggerEmulationDoubleEG(&*ele, false);                      // Keep in mind, this trigger emulation is for 2016 DoubleEG, the SingleEG trigger emulation is different
+        _lElectronPassHOverE[_nL]       = passHOverEDoubleEG(&*ele);
+        _lElectronPassEmu[_nL]          = _lElectronPassEmuNoHOverE[_nL] && _lElectronPassHOverE[_nL];
         _lElectronPassConvVeto[_nL]     = ele->passConversionVeto();
         _lElectronChargeConst[_nL]      = ele->isGsfCtfScPixChargeConsistent();
         _lElectronMissingHits[_nL]      = ele->gsfTrack()->hitPattern().numberOfLostHits(reco::HitPattern::MISSING_INNER_HITS);
 
-        _lHNLoose[_nL]                  = isHNLoose(*ele);
-        _lHNFO[_nL]                     = isHNFO(*ele);
-        _lHNTight[_nL]                  = isHNTight(*ele);
+        _lPOGVeto[_nL]                  = electronIds.value(ele->electronIDs(), cutBasedVeto);
+        _lPOGLoose[_nL]                 = electronIds.value(ele->electronIDs(), cutBasedLoose);
+        _lPOGMedium[_nL]                = electronIds.value(ele->electronIDs(), cutBasedMedium);
+        _lPOGTight[_nL]                 = electronIds.value(ele->electronIDs(), cutBasedTight);
 
-        _lPOGVeto[_nL]                  = ele->electronID("cutBasedElectronID-Fall17-94X-V1-veto");
-        _lPOGLoose[_nL]                 = ele->electronID("cutBasedElectronID-Fall17-94X-V1-loose");
-        _lPOGMedium[_nL]                = ele->electronID("cutBasedElectronID-Fall17-94X-V1-medium");
-        _lPOGTight[_nL]                 = ele->electronID("cutBasedElectronID-Fall17-94X-V1-tight");
-
-        _leptonMvaSUSY16[_nL]           = leptonMvaVal(*ele, leptonMvaComputerSUSY16);
-        _leptonMvaTTH16[_nL]            = leptonMvaVal(*ele, leptonMvaComputerTTH16);
-        _leptonMvaSUSY17[_nL]           = leptonMvaVal(*ele, leptonMvaComputerSUSY17);
-        _leptonMvaTTH17[_nL]            = leptonMvaVal(*ele, leptonMvaComputerTTH17);
-        _leptonMvatZqTTV16[_nL]         = leptonMvaVal(*ele, leptonMvaComputertZqTTV16);
-        _leptonMvatZqTTV17[_nL]         = leptonMvaVal(*ele, leptonMvaComputertZqTTV17);
-
-        _lEwkLoose[_nL]                 = isEwkLoose(*ele);
-        _lEwkFO[_nL]                    = isEwkFO(*ele);
-        _lEwkTight[_nL]                 = isEwkTight(*ele);
+        fillLeptonMvaFeatures(*ele);                                                                     // lepton MVAs and ids are evaluated for all electrons at once after the loop
 
         // Note: for the scale and smearing systematics we use the overall values, assuming we are not very sensitive to these systematics
         // In case these systematics turn out to be important, need to add their individual source to the tree (and propagate to their own templates):
         // https://twiki.cern.ch/twiki/bin/viewauth/CMS/EgammaMiniAODV2#Energy_Scale_and_Smearing
         // Currently only available for 2016/2017
         if(!multilepAnalyzer->is2018){
-          _lPtCorr[_nL]                 = ele->pt()*ele->userFloat("ecalTrkEnergyPostCorr")/ele->energy();
-          _lPtScaleUp[_nL]              = ele->pt()*ele->userFloat("energyScaleUp")/ele->energy();
-          _lPtScaleDown[_nL]            = ele->pt()*ele->userFloat("energyScaleDown")/ele->energy();
-          _lPtResUp[_nL]                = ele->pt()*ele->userFloat("energySigmaUp")/ele->energy();
-          _lPtResDown[_nL]              = ele->pt()*ele->userFloat("energySigmaDown")/ele->energy();
           _lECorr[_nL]                  = ele->userFloat("ecalTrkEnergyPostCorr");
           _lEScaleUp[_nL]               = ele->userFloat("energyScaleUp");
           _lEScaleDown[_nL]             = ele->userFloat("energyScaleDown");
           _lEResUp[_nL]                 = ele->userFloat("energySigmaUp");
           _lEResDown[_nL]               = ele->userFloat("energySigmaDown");
+          _lPtCorr[_nL]                 = ele->pt()*_lECorr[_nL]/ele->energy();
+          _lPtScaleUp[_nL]              = ele->pt()*_lEScaleUp[_nL]/ele->energy();
+          _lPtScaleDown[_nL]            = ele->pt()*_lEScaleDown[_nL]/ele->energy();
+          _lPtResUp[_nL]                = ele->pt()*_lEResUp[_nL]/ele->energy();
+          _lPtResDown[_nL]              = ele->pt()*_lEResDown[_nL]/ele->energy();
         }
 
         ++_nEle;
@@ -264,6 +334,9 @@ bool LeptonAnalyzer::analyze(const edm::Event& iEvent, const reco::Vertex& prima
         ++_nLight;
     }
 
+    computeLeptonMvas(electronMvaFeatures, _nMu, false);
+    computeLeptonIds(_nMu, _nEle, true);                                                             // overlap with the muons passing the same id
+
     //Initialize with default values for those electron-only arrays which weren't filled with muons [to allow correct comparison by the test script]
     for(auto array : {&_lEtaSC}) std::fill_n(*array, _nMu, 0.);
     for(auto array : {&_lElectronMvaSummer16GP, &_lElectronMvaSummer16HZZ, &_lElectronMvaFall17v1NoIso}) std::fill_n(*array, _nMu, 0.); // OLD, do not use them
@@ -275,44 +348,41 @@ bool LeptonAnalyzer::analyze(const edm::Event& iEvent, const reco::Vertex& prima
 
     //loop over taus
     for(const pat::Tau& tau : *taus){
-        if(_nL == nL_max)         break;
-        if(tau.pt() < 20)         continue;          // Minimum pt for tau reconstruction
-        if(fabs(tau.eta()) > 2.3) continue;
-        //if(!tau.tauID("decayModeFinding")) continue;
+        if(_nL == nL_max)                      break;
+        if(!isPreselected(tau, primaryVertex)) continue;
         fillLeptonKinVars(tau);
         if(!multilepAnalyzer->isData) fillLeptonGenVars(tau, *genParticles);
         fillLeptonImpactParameters(tau, primaryVertex);
-        if(_dz[_nL] < 0.4)        continue;         //tau dz cut used in ewkino  --> is this a standard cut? reference?
 
         _lFlavor[_nL]                   = 2;
-        _tauMuonVeto[_nL]               = tau.tauID("againstMuonLoose3");                        //Light lepton vetos
-        _tauEleVeto[_nL]                = tau.tauID("againstElectronLooseMVA6");
-
-        _lPOGVeto[_nL]                  = tau.tauID("byVLooseIsolationMVArun2v1DBoldDMwLT");     //old tau ID
-        _lPOGLoose[_nL]                 = tau.tauID("byLooseIsolationMVArun2v1DBoldDMwLT");
-        _lPOGMedium[_nL]                = tau.tauID("byMediumIsolationMVArun2v1DBoldDMwLT");
-        _lPOGTight[_nL]                 = tau.tauID("byTightIsolationMVArun2v1DBoldDMwLT");
-        _tauVTightMvaOld[_nL]           = tau.tauID("byVTightIsolationMVArun2v1DBoldDMwLT");
-
-        _decayModeFindingNew[_nL]       = tau.tauID("decayModeFindingNewDMs");                   //new Tau ID
-        _tauVLooseMvaNew[_nL]           = tau.tauID("byVLooseIsolationMVArun2v1DBnewDMwLT");
-        _tauLooseMvaNew[_nL]            = tau.tauID("byLooseIsolationMVArun2v1DBnewDMwLT");
-        _tauMediumMvaNew[_nL]           = tau.tauID("byMediumIsolationMVArun2v1DBnewDMwLT");
-        _tauTightMvaNew[_nL]            = tau.tauID("byTightIsolationMVArun2v1DBnewDMwLT");
-        _tauVTightMvaNew[_nL]           = tau.tauID("byVTightIsolationMVArun2v1DBnewDMwLT");
-
-        _tauAgainstElectronMVA6Raw[_nL] = tau.tauID("againstElectronMVA6Raw");
-        _tauCombinedIsoDBRaw3Hits[_nL]  = tau.tauID("byCombinedIsolationDeltaBetaCorrRaw3Hits");
-        _tauIsoMVAPWdR03oldDMwLT[_nL]   = tau.tauID("byIsolationMVArun2v1PWdR03oldDMwLTraw");
-        _tauIsoMVADBdR03oldDMwLT[_nL]   = tau.tauID("byIsolationMVArun2v1DBoldDMwLTraw");
-        _tauIsoMVADBdR03newDMwLT[_nL]   = tau.tauID("byIsolationMVArun2v1DBnewDMwLTraw");
-        _tauIsoMVAPWnewDMwLT[_nL]       = tau.tauID("byIsolationMVArun2v1PWnewDMwLTraw");
-        _tauIsoMVAPWoldDMwLT[_nL]       = tau.tauID("byIsolationMVArun2v1PWoldDMwLTraw");
+        _tauMuonVeto[_nL]               = tauIds.value(tau.tauIDs(), againstMuonLoose3);                        //Light lepton vetos
+        _tauEleVeto[_nL]                = tauIds.value(tau.tauIDs(), againstElectronLooseMVA6);
+
+        _lPOGVeto[_nL]                  = tauIds.value(tau.tauIDs(), byVLooseIsolationMVArun2v1DBoldDMwLT);     //old tau ID
+        _lPOGLoose[_nL]                 = tauIds.value(tau.tauIDs(), byLooseIsolationMVArun2v1DBoldDMwLT);
+        _lPOGMedium[_nL]                = tauIds.value(tau.tauIDs(), byMediumIsolationMVArun2v1DBoldDMwLT);
+        _lPOGTight[_nL]                 = tauIds.value(tau.tauIDs(), byTightIsolationMVArun2v1DBoldDMwLT);
+        _tauVTightMvaOld[_nL]           = tauIds.value(tau.tauIDs(), byVTightIsolationMVArun2v1DBoldDMwLT);
+
+        _decayModeFindingNew[_nL]       = tauIds.value(tau.tauIDs(), decayModeFindingNewDMs);                   //new Tau ID
+        _tauVLooseMvaNew[_nL]           = tauIds.value(tau.tauIDs(), byVLooseIsolationMVArun2v1DBnewDMwLT);
+        _tauLooseMvaNew[_nL]            = tauIds.value(tau.tauIDs(), byLooseIsolationMVArun2v1DBnewDMwLT);
+        _tauMediumMvaNew[_nL]           = tauIds.value(tau.tauIDs(), byMediumIsolationMVArun2v1DBnewDMwLT);
+        _tauTightMvaNew[_nL]            = tauIds.value(tau.tauIDs(), byTightIsolationMVArun2v1DBnewDMwLT);
+        _tauVTightMvaNew[_nL]           = tauIds.value(tau.tauIDs(), byVTightIsolationMVArun2v1DBnewDMwLT);
+
+        _tauAgainstElectronMVA6Raw[_nL] = tauIds.value(tau.tauIDs(), againstElectronMVA6Raw);
+        _tauCombinedIsoDBRaw3Hits[_nL]  = tauIds.value(tau.tauIDs(), byCombinedIsolationDeltaBetaCorrRaw3Hits);
+        _tauIsoMVAPWdR03oldDMwLT[_nL]   = tauIds.value(tau.tauIDs(), byIsolationMVArun2v1PWdR03oldDMwLTraw);
+        _tauIsoMVADBdR03oldDMwLT[_nL]   = tauIds.value(tau.tauIDs(), byIsolationMVArun2v1DBoldDMwLTraw);
+        _tauIsoMVADBdR03newDMwLT[_nL]   = tauIds.value(tau.tauIDs(), byIsolationMVArun2v1DBnewDMwLTraw);
+        _tauIsoMVAPWnewDMwLT[_nL]       = tauIds.value(tau.tauIDs(), byIsolationMVArun2v1PWnewDMwLTraw);
+        _tauIsoMVAPWoldDMwLT[_nL]       = tauIds.value(tau.tauIDs(), byIsolationMVArun2v1PWoldDMwLTraw);
         // TODO:  Should try also deepTau?
 
         _lEwkLoose[_nL] = isEwkLoose(tau);
-        _lEwkFO[_nL]    = isEwkFO(tau);
-        _lEwkTight[_nL] = isEwkTight(tau);
+        _lEwkFO[_nL]    = isEwkFO(tau, _nL);
+        _lEwkTight[_nL] = isEwkTight(tau, _nL);
         ++_nTau;
         ++_nL;
     }
@@ -322,14 +392,6 @@ bool LeptonAnalyzer::analyze(const edm::Event& iEvent, const reco::Vertex& prima
     for(auto array : {&_tauMediumMvaNew, &_tauTightMvaNew, &_tauVTightMvaNew, &_tauVTightMvaOld}) std::fill_n(*array, _nLight, false);
     for(auto array : {&_tauAgainstElectronMVA6Raw, &_tauCombinedIsoDBRaw3Hits, &_tauIsoMVAPWdR03oldDMwLT}) std::fill_n(*array, _nLight, 0.);
     for(auto array : {&_tauIsoMVADBdR03oldDMwLT, &_tauIsoMVADBdR03newDMwLT, &_tauIsoMVAPWnewDMwLT, &_tauIsoMVAPWoldDMwLT}) std::fill_n(*array, _nLight, 0.);
-
-
-    if(multilepAnalyzer->skim == "trilep"    &&  _nL     < 3) return false;
-    if(multilepAnalyzer->skim == "dilep"     &&  _nL     < 2) return false;
-    if(multilepAnalyzer->skim == "ttg"       &&  _nLight < 2) return false;
-    if(multilepAnalyzer->skim == "singlelep" &&  _nL     < 1) return false;
-    if(multilepAnalyzer->skim == "FR"        &&  _nLight < 1) return false;
-    return true;
 }
 
 void LeptonAnalyzer::fillLeptonKinVars(const reco::Candidate& lepton){
@@ -338,16 +400,21 @@ void LeptonAnalyzer::fillLeptonKinVars(const reco::Candidate& lepton){
     _lPhi[_nL]    = lepton.phi();
     _lE[_nL]      = lepton.energy();
     _lCharge[_nL] = lepton.charge();
+
+    leptonDeltaR2s[_nL][_nL] = 0.;                                                                   // deltaR^2 to the leptons stored before, for the overlap removal
+    for(unsigned l = 0; l < _nL; ++l){
+        leptonDeltaR2s[_nL][l] = leptonDeltaR2s[l][_nL] = reco::deltaR2(_lEta[_nL], _lPhi[_nL], _lEta[l], _lPhi[l]);
+    }
 }
 
 template <typename Lepton> void LeptonAnalyzer::fillLeptonGenVars(const Lepton& lepton, const std::vector<reco::GenParticle>& genParticles){
     const reco::GenParticle* match = lepton.genParticle();
-    if(!match or match->pdgId() != lepton.pdgId()) match = GenTools::geometricMatch(lepton, genParticles); // if no match or pdgId is different, try the geometric match
+    if(!match or match->pdgId() != lepton.pdgId()) match = GenTools::geometricMatch(lepton, multilepAnalyzer->genEventView); // if no match or pdgId is different, try the geometric match
 
     _lIsPrompt[_nL]             = match and (abs(lepton.pdgId()) == abs(match->pdgId()) || match->pdgId() == 22) and GenTools::isPrompt(*match, genParticles); // only when matched to its own flavor or a photon
     _lMatchPdgId[_nL]           = match ? match->pdgId() : 0;
-    _lProvenance[_nL]           = GenTools::provenance(match, genParticles);
-    _lProvenanceCompressed[_nL] = GenTools::provenanceCompressed(match, genParticles, _lIsPrompt[_nL]);
+    _lProvenance[_nL]           = GenTools::provenance(match, multilepAnalyzer->genAncestry);
+    _lProvenanceCompressed[_nL] = GenTools::provenanceCompressed(match, multilepAnalyzer->genAncestry, _lIsPrompt[_nL]);
     _lProvenanceConversion[_nL] = GenTools::provenanceConversion(match, genParticles);
     _lMomPdgId[_nL]             = match ? (GenTools::getMother(*match, genParticles))->pdgId() : 0;
 }
@@ -388,20 +455,13 @@ double LeptonAnalyzer::tau_dz(const pat::Tau& tau, const reco::Vertex::Point& ve
 
 
 
-void LeptonAnalyzer::fillLeptonJetVariables(const reco::Candidate& lepton, edm::Handle<std::vector<pat::Jet>>& jets, const reco::Vertex& vertex, const double rho){
-    //Make skimmed "close jet" collection
-    std::vector<pat::Jet> selectedJetsAll;
-    for(auto jet = jets->cbegin(); jet != jets->cend(); ++jet){
-        if(jet->pt() > 5 && fabs( jet->eta() ) < 3) selectedJetsAll.push_back(*jet);
-    }
-    // Find closest selected jet
-    unsigned closestIndex = 0;
-    for(unsigned j = 1; j < selectedJetsAll.size(); ++j){
-        if(reco::deltaR(selectedJetsAll[j], lepton) < reco::deltaR(selectedJetsAll[closestIndex], lepton)) closestIndex = j;
-    }
+void LeptonAnalyzer::fillLeptonJetVariables(const reco::Candidate& lepton){
+    // Find closest selected jet in the per-event jet view
+    JetView& jets = multilepAnalyzer->jetView;
+    jets.associate(_nL, lepton);
+    const unsigned closest = jets.closestJet(_nL);
 
-    const pat::Jet& jet = selectedJetsAll[closestIndex];
-    if(selectedJetsAll.size() == 0 || reco::deltaR(jet, lepton) > 0.4){ //Now includes safeguard for 0 jet events
+    if(jets.size() == 0 || jets.deltaR(_nL, closest) > 0.4){ //Now includes safeguard for 0 jet events
         _ptRatio[_nL]              = 1;
         _ptRel[_nL]                = 0;
         _closestJetCsvV2[_nL]      = 0;
@@ -409,8 +469,8 @@ void LeptonAnalyzer::fillLeptonJetVariables(const reco::Candidate& lepton, edm::
         _closestJetDeepCsv_bb[_nL] = 0;
         _selectedTrackMult[_nL]    = 0;
     } else {
-        auto  l1Jet       = jet.correctedP4("L1FastJet");
-        float JEC         = jet.p4().E()/l1Jet.E();
+        auto  l1Jet       = jets.l1P4(closest);
+        float JEC         = jets.p4(closest).E()/l1Jet.E();
         auto  l           = lepton.p4();
         auto  lepAwareJet = (l1Jet - l)*JEC + l;
 
@@ -418,32 +478,11 @@ void LeptonAnalyzer::fillLeptonJetVariables(const reco::Candidate& lepton, edm::
         TLorentzVector jV(lepAwareJet.Px(), lepAwareJet.Py(), lepAwareJet.Pz(), lepAwareJet.E());
         _ptRatio[_nL]              = l.Pt()/lepAwareJet.Pt();
         _ptRel[_nL]                = lV.Perp((jV - lV).Vect());
-        _closestJetCsvV2[_nL]      = jet.bDiscriminator("pfCombinedInclusiveSecondaryVertexV2BJetTags");
-        _closestJetDeepCsv_b[_nL]  = jet.bDiscriminator("pfDeepCSVJetTags:probb");
-        _closestJetDeepCsv_bb[_nL] = jet.bDiscriminator("pfDeepCSVJetTags:probbb");
-
-        //compute selected track multiplicity of closest jet
-        _selectedTrackMult[_nL] = 0;
-        for(unsigned d = 0; d < jet.numberOfDaughters(); ++d){
-            const pat::PackedCandidate* daughter = (const pat::PackedCandidate*) jet.daughter(d);
-            if(daughter->hasTrackDetails()){
-                const reco::Track& daughterTrack = daughter->pseudoTrack();
-                if(daughterTrack.pt() <= 1)                                 continue;
-                if(daughterTrack.charge() == 0)                             continue;
-                if(daughter->fromPV() < 2)                                  continue;
-                if(daughterTrack.hitPattern().numberOfValidHits() < 8)      continue;
-                if(daughterTrack.hitPattern().numberOfValidPixelHits() < 2) continue;
-                if(daughterTrack.normalizedChi2() >= 5)                     continue;
-                if(fabs(daughterTrack.dz(vertex.position())) >= 17)         continue;
-                if(fabs(daughterTrack.dxy(vertex.position())) >= 0.2)       continue;
-
-
-                //distance from jet core
-                TLorentzVector trackVec(daughterTrack.px(), daughterTrack.py(), daughterTrack.pz(), daughterTrack.p());
-                double daughterDeltaR = trackVec.DeltaR(jV);
-
-                if(daughterDeltaR <= 0.4) ++_selectedTrackMult[_nL];
-            }
-        }
+        _closestJetCsvV2[_nL]      = jets.csvV2(closest);
+        _closestJetDeepCsv_b[_nL]  = jets.deepCsvB(closest);
+        _closestJetDeepCsv_bb[_nL] = jets.deepCsvBB(closest);
+
+        //compute selected track multiplicity of closest jet, the track selection is cached per jet
+        _selectedTrackMult[_nL]    = jets.selectedTrackMult(closest, jV);
     }
 }
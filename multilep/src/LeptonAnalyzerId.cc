@@ -1,30 +1,27 @@
 #include "../interface/LeptonAnalyzer.h"
-#include "TLorentzVector.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <type_traits>
 
 /*
- * Overlap of electrons with loose muons
+ * Overlap of electrons with muons, for all ids at once: bit id is set when a muon passing that id is within deltaR 0.05
  * Overlap of taus with loose electrons or muons
+ * Both from the deltaR^2 matrix of the stored leptons
  */
-bool LeptonAnalyzer::eleMuOverlap(const pat::Electron& ele, const bool* loose) const{
-    TLorentzVector eleV(ele.px(), ele.py(), ele.pz(), ele.energy());
+unsigned LeptonAnalyzer::muonOverlapIds(const unsigned l) const{
+    unsigned ids = 0;
     for(unsigned m = 0; m < _nMu; ++m){
-        if(loose[m]){
-            TLorentzVector muV;
-            muV.SetPtEtaPhiE(_lPt[m], _lEta[m], _lPhi[m], _lE[m]);
-            if(eleV.DeltaR(muV) < 0.05) return true;
+        if(leptonDeltaR2s[l][m] >= 0.05*0.05) continue;
+        for(unsigned id = 0; id < nLeptonIds; ++id){
+            if(leptonIdFlags[id][m]) ids |= (1 << id);
         }
     }
-    return false;
+    return ids;
 }
 
-bool LeptonAnalyzer::tauLightOverlap(const pat::Tau& tau, const bool* loose) const{
-    TLorentzVector tauV(tau.px(), tau.py(), tau.pz(), tau.energy());
-    for(unsigned l = 0; l < _nLight; ++l){
-        if(loose[l]){
-            TLorentzVector lightV;
-            lightV.SetPtEtaPhiE(_lPt[l], _lEta[l], _lPhi[l], _lE[l]);
-            if(tauV.DeltaR(lightV) < 0.4) return true;
-        }
+bool LeptonAnalyzer::tauLightOverlap(const unsigned l, const bool* loose) const{
+    for(unsigned light = 0; light < _nLight; ++light){
+        if(loose[light] && leptonDeltaR2s[l][light] < 0.4*0.4) return true;
     }
     return false;
 }
@@ -40,10 +37,14 @@ bool LeptonAnalyzer::passTriggerEmulationDoubleEG(const pat::Electron* ele, cons
     if(fabs(ele->deltaEtaSuperClusterTrackAtVtx()) >= (ele->isEB() ? 0.01  : 0.008)) return false;
     if(eInvMinusPInv                               <= -0.05)                         return false;
     if(eInvMinusPInv                               >= (ele->isEB() ? 0.01  : 0.005)) return false;
-    if(hOverE && (ele->hadronicOverEm()            >= (ele->isEB() ? 0.10  : 0.07))) return false;//Need to be able to check trigEmy without this cut for ewkino
+    if(hOverE && !passHOverEDoubleEG(ele))                                           return false;//Need to be able to check trigEmy without this cut for ewkino
     return true;
 }
 
+bool LeptonAnalyzer::passHOverEDoubleEG(const pat::Electron* ele) const{
+    return ele->hadronicOverEm() < (ele->isEB() ? 0.10  : 0.07);
+}
+
 /*
  * SUSY POG MVA definitions [still here for dependencies in HN and EWK ID's, NEVER use them in new analyses]
  */
@@ -52,94 +53,47 @@ float LeptonAnalyzer::slidingCut(float pt, float low, float high) const{
     return std::min(low, std::max(high, low + slope*(pt-15)));
 }
 
-bool LeptonAnalyzer::passingElectronMvaHZZ(const pat::Electron* ele, double mvaValueHZZ) const{
-    if(fabs(ele->eta()) < 0.8)         return mvaValueHZZ > -0.3; 
-    else if (fabs(ele->eta()) < 1.479) return mvaValueHZZ > -0.36;
+bool LeptonAnalyzer::passingElectronMvaHZZ(double pt, double eta, double mvaValueHZZ) const{
+    if(fabs(eta) < 0.8)                return mvaValueHZZ > -0.3; 
+    else if (fabs(eta) < 1.479)        return mvaValueHZZ > -0.36;
     else                               return mvaValueHZZ > -0.63;
 }
 
-bool LeptonAnalyzer::passingElectronMvaLooseSusy(const pat::Electron* ele, double mvaValue, double mvaValueHZZ) const{
-    if(ele->pt() < 10)                 return passingElectronMvaHZZ(ele, mvaValueHZZ);
-    if(fabs(ele->eta()) < 0.8)         return mvaValue > slidingCut(ele->pt(), -0.86, -0.96);
-    else if (fabs(ele->eta()) < 1.479) return mvaValue > slidingCut(ele->pt(), -0.85, -0.96);
-    else                               return mvaValue > slidingCut(ele->pt(), -0.81, -0.95);
+bool LeptonAnalyzer::passingElectronMvaLooseSusy(double pt, double eta, double mvaValue, double mvaValueHZZ) const{
+    if(pt < 10)                        return passingElectronMvaHZZ(pt, eta, mvaValueHZZ);
+    if(fabs(eta) < 0.8)                return mvaValue > slidingCut(pt, -0.86, -0.96);
+    else if (fabs(eta) < 1.479)        return mvaValue > slidingCut(pt, -0.85, -0.96);
+    else                               return mvaValue > slidingCut(pt, -0.81, -0.95);
 }
 
-bool LeptonAnalyzer::passingElectronMvaTightSusy(const pat::Electron* ele, double mvaValue) const{
-    if(ele->pt() < 10)                 return false; 
-    if(fabs(ele->eta()) < 0.8)         return mvaValue > slidingCut(ele->pt(),  0.77,  0.52);
-    else if (fabs(ele->eta()) < 1.479) return mvaValue > slidingCut(ele->pt(),  0.56,  0.11);
-    else                               return mvaValue > slidingCut(ele->pt(),  0.48, -0.01);
+bool LeptonAnalyzer::passingElectronMvaTightSusy(double pt, double eta, double mvaValue) const{
+    if(pt < 10)                        return false; 
+    if(fabs(eta) < 0.8)                return mvaValue > slidingCut(pt,  0.77,  0.52);
+    else if (fabs(eta) < 1.479)        return mvaValue > slidingCut(pt,  0.56,  0.11);
+    else                               return mvaValue > slidingCut(pt,  0.48, -0.01);
 }
 
 /*
  * Own HeavyNeutrino FO tune [tuned on a very old electronMva, do NOT use them for new analyses]
  */
-bool LeptonAnalyzer::passingElectronMvaHeavyNeutrinoFO(const pat::Electron* ele, double mvaValue) const{
-    if(ele->pt() < 10)                 return false; 
-    if(fabs(ele->eta()) < 0.8)         return mvaValue > -0.02;
+bool LeptonAnalyzer::passingElectronMvaHeavyNeutrinoFO(double pt, double eta, double mvaValue) const{
+    if(pt < 10)                        return false; 
+    if(fabs(eta) < 0.8)                return mvaValue > -0.02;
     else                               return mvaValue > -0.52;
 }
 
 /*
  * Ewkino FO tune [tuned on a very old electronMva, do NOT use them for new analyses]
  */
-bool LeptonAnalyzer::passElectronMvaEwkFO(const pat::Electron* ele, double mvaValue) const{
-    if(ele->pt() < 10)               return false;
-    if(fabs(ele->eta()) < 1.479)     return mvaValue > 0.0;
+bool LeptonAnalyzer::passElectronMvaEwkFO(double pt, double eta, double mvaValue) const{
+    if(pt < 10)                      return false;
+    if(fabs(eta) < 1.479)            return mvaValue > 0.0;
     else                             return mvaValue > 0.3;
 }
 
 
-/*
- * Id definitions for the heavyNeutrino analysis
- */
-// Important: not official-loose like in POG-loose, but own-made loose, never call this a 'loose' lepton in a presentation
-bool LeptonAnalyzer::isHNLoose(const pat::Muon& lepton) const{
-    if(fabs(_dxy[_nL]) >= 0.05 || fabs(_dz[_nL]) >= 0.1) return false;
-    if(_relIso[_nL] >= 0.6)                              return false;
-    return (lepton.isLooseMuon() && lepton.pt() > 5); 
-}
-
-bool LeptonAnalyzer::isHNLoose(const pat::Electron& lepton) const{
-    if(fabs(_dxy[_nL]) >= 0.05 || fabs(_dz[_nL]) >= 0.1)                                            return false;
-    if(_relIso[_nL] >= 0.6)                                                                         return false;
-    if(lepton.gsfTrack()->hitPattern().numberOfLostHits(reco::HitPattern::MISSING_INNER_HITS) > 1)  return false;
-    if(!lepton.passConversionVeto())                                                                return false;
-    if(eleMuOverlap(lepton, _lHNLoose))                                                             return false; // Always run electrons after muons because of this
-    return (lepton.pt() > 10);
-}
-
-bool LeptonAnalyzer::isHNFO(const pat::Muon& lepton) const{
-    if(!_lHNLoose[_nL])                         return false; // own-made loose, not POG-loose
-    if(fabs(_3dIPSig[_nL]) >= 4)                return false;
-    return lepton.isMediumMuon();
-}
-
-bool LeptonAnalyzer::isHNFO(const pat::Electron& lepton) const{
-    if(!_lHNLoose[_nL])                                                                                 return false; // own-made loose, not POG-loose
-    if(fabs(_3dIPSig[_nL]) >= 4)                                                                        return false;
-    if(lepton.gsfTrack()->hitPattern().numberOfLostHits(reco::HitPattern::MISSING_INNER_HITS) != 0)     return false;
-    if(!passTriggerEmulationDoubleEG(&lepton))                                                          return false;
-    if(!passingElectronMvaHeavyNeutrinoFO(&lepton, _lElectronMvaSummer16GP[_nL]))                       return false; // TODO: consider replacing this by somethinig better
-    return true;
-}
-
-bool LeptonAnalyzer::isHNTight(const pat::Electron& lepton) const{
-    if(!_lHNFO[_nL])                                                        return false;
-    if(_relIso[_nL] >= 0.1)                                                 return false;
-    if(!passingElectronMvaTightSusy(&lepton, _lElectronMvaSummer16GP[_nL])) return false; // TODO: consider replacing this by something better
-    return true;
-}
-
-bool LeptonAnalyzer::isHNTight(const pat::Muon& lepton) const{
-    if(!_lHNFO[_nL])        return false;
-    if(_relIso[_nL] >= 0.1) return false;
-    return true;
-}
-
-double LeptonAnalyzer::leptonMvaVal(const pat::Muon& muon, LeptonMvaHelper* mvaHelper){
-    return mvaHelper->leptonMvaMuon(_lPt[_nL],
+void LeptonAnalyzer::fillLeptonMvaFeatures(const pat::Muon& muon){
+    muonMvaFeatures.add(_lPt[_nL],
             _lEta[_nL],
             _selectedTrackMult[_nL],
             _miniIsoCharged[_nL],
@@ -153,12 +107,13 @@ double LeptonAnalyzer::leptonMvaVal(const pat::Muon& muon, LeptonMvaHelper* mvaH
             _dz[_nL],
             _relIso[_nL],
             _relIso0p4[_nL],
-            muon.segmentCompatibility()
+            muon.segmentCompatibility(),
+            0., 0., 0.
             );
 }
 
-double LeptonAnalyzer::leptonMvaVal(const pat::Electron& electron, LeptonMvaHelper* mvaHelper){
-    return mvaHelper->leptonMvaElectron(_lPt[_nL],
+void LeptonAnalyzer::fillLeptonMvaFeatures(const pat::Electron& electron){
+    electronMvaFeatures.add(_lPt[_nL],
             _lEta[_nL],
             _selectedTrackMult[_nL],
             _miniIsoCharged[_nL],
@@ -172,72 +127,131 @@ double LeptonAnalyzer::leptonMvaVal(const pat::Electron& electron, LeptonMvaHelp
             _dz[_nL],
             _relIso[_nL],
             _relIso0p4[_nL],
+            0.,
             _lElectronMvaSummer16GP[_nL],
             _lElectronMvaSummer16HZZ[_nL],
             _lElectronMvaFall17v1NoIso[_nL]
             );
 }
 
-bool LeptonAnalyzer::isEwkLoose(const pat::Muon& lep) const{
-    if(fabs(_dxy[_nL]) >= 0.05 || fabs(_dz[_nL]) >= 0.1 || _3dIPSig[_nL] >= 8)      return false;
-    if(_miniIso[_nL] >= 0.4)                                                        return false;
-    if(_lPt[_nL] <= 5 || fabs(_lEta[_nL]) >= 2.4)                                   return false;
-    return lep.isLooseMuon();
-}
-
-bool LeptonAnalyzer::isEwkLoose(const pat::Electron& lep) const{
-    if(fabs(_dxy[_nL]) >= 0.05 || fabs(_dz[_nL]) >= 0.1 || _3dIPSig[_nL] >= 8)                      return false;
-    if(_miniIso[_nL] >= 0.4)                                                                        return false;
-    if(_lPt[_nL] <= 7 || fabs(_lEta[_nL]) >= 2.5)                                                   return false;
-    if(lep.gsfTrack()->hitPattern().numberOfLostHits(reco::HitPattern::MISSING_INNER_HITS) > 1)     return false;
-    if(eleMuOverlap(lep, _lEwkLoose))                                                               return false;
-    return passingElectronMvaLooseSusy(&lep, _lElectronMvaSummer16GP[_nL], _lElectronMvaSummer16HZZ[_nL]); // TODO: consider replacing this by something better
+/*
+ * All lepton MVAs for the muons or electrons of the event at once, starting at index first in the lepton arrays
+ */
+void LeptonAnalyzer::computeLeptonMvas(const LeptonMvaFeatures& features, const unsigned first, const bool muons){
+    for(const LeptonMva& mva : leptonMvas){
+        if(!mva.helper) continue;
+        if(muons) mva.helper->leptonMvaMuons(features, mva.values + first);
+        else      mva.helper->leptonMvaElectrons(features, mva.values + first);
+    }
 }
 
-bool LeptonAnalyzer::isEwkLoose(const pat::Tau& tau) const{
-    if( _lPt[_nL] <= 20 || fabs(_lEta[_nL]) >= 2.3)     return false;
-    if(!_lPOGVeto[_nL])                                 return false;
-    if(!_tauEleVeto[_nL])                               return false;
-    return tauLightOverlap(tau, _lEwkLoose);
+/*
+ * Id definitions for the heavyNeutrino and ewkino analyses, as cut tables given per era in the leptonIds PSet
+ * Important: HN loose is not official-loose like in POG-loose, but own-made loose, never call this a 'loose' lepton in a presentation
+ * [the electron MVA working points are tuned on very old electronMvas, do NOT use them for new analyses]
+ */
+LeptonAnalyzer::LeptonIdCuts LeptonAnalyzer::readLeptonIdCuts(const edm::ParameterSet& pset) const{
+    LeptonIdCuts cuts;
+    auto readElectronMva = [&pset](const std::string& name){
+        if(!pset.exists(name)) return noElectronMva;
+        const std::string mva = pset.getParameter<std::string>(name);
+        if(mva == "HNFO")      return electronMvaHNFO;
+        if(mva == "SUSYLoose") return electronMvaSUSYLoose;
+        if(mva == "SUSYTight") return electronMvaSUSYTight;
+        if(mva == "EwkFO")     return electronMvaEwkFO;
+        throw cms::Exception("LeptonAnalyzer") << "Unknown electron MVA working point " << mva << " in the leptonIds PSet";
+    };
+    auto read = [&pset](const std::string& name, auto& cut){
+        if(pset.exists(name)) cut = pset.getParameter<typename std::remove_reference<decltype(cut)>::type>(name);
+    };
+    read("minPt",                    cuts.minPt);
+    read("maxEta",                   cuts.maxEta);
+    read("maxDxy",                   cuts.maxDxy);
+    read("maxDz",                    cuts.maxDz);
+    read("max3dIPSig",               cuts.max3dIPSig);
+    read("maxRelIso",                cuts.maxRelIso);
+    read("maxMiniIso",               cuts.maxMiniIso);
+    read("maxMissingHits",           cuts.maxMissingHits);
+    read("looseMuon",                cuts.looseMuon);
+    read("mediumMuon",               cuts.mediumMuon);
+    read("convVeto",                 cuts.convVeto);
+    read("triggerEmulation",         cuts.triggerEmulation);
+    read("triggerEmulationNoHOverE", cuts.triggerEmulationNoHOverE);
+    read("muonOverlap",              cuts.muonOverlap);
+    read("minLeptonMva",             cuts.minLeptonMva);
+    read("minPtRatio",               cuts.minPtRatio);
+    read("maxClosestJetCsv",         cuts.maxClosestJetCsv);
+    read("hOverEConePt",             cuts.hOverEConePt);
+    cuts.electronMva            = readElectronMva("electronMva");
+    cuts.alternativeElectronMva = readElectronMva("alternativeElectronMva");
+    return cuts;
 }
 
-bool LeptonAnalyzer::isEwkFO(const pat::Muon& lep) const{
-    if(!_lEwkLoose[_nL])        return false;
-    if(_lPt[_nL] <= 10)         return false;
-    if(!lep.isMediumMuon())     return false;
-    return _leptonMvaSUSY16[_nL] > -0.2 || (_ptRatio[_nL] > 0.3 && _closestJetCsvV2[_nL] < 0.3);
+bool LeptonAnalyzer::passElectronMva(const ElectronMva mva, const unsigned l) const{
+    switch(mva){
+      case electronMvaHNFO:      return passingElectronMvaHeavyNeutrinoFO(_lPt[l], _lEta[l], _lElectronMvaSummer16GP[l]);
+      case electronMvaSUSYLoose: return passingElectronMvaLooseSusy(_lPt[l], _lEta[l], _lElectronMvaSummer16GP[l], _lElectronMvaSummer16HZZ[l]);
+      case electronMvaSUSYTight: return passingElectronMvaTightSusy(_lPt[l], _lEta[l], _lElectronMvaSummer16GP[l]);
+      case electronMvaEwkFO:     return passElectronMvaEwkFO(_lPt[l], _lEta[l], _lElectronMvaSummer16GP[l]);
+      default:                   return true;
+    }
 }
 
-bool LeptonAnalyzer::isEwkFO(const pat::Electron& lep) const{
-    if(!_lEwkLoose[_nL])                                                                            return false;
-    if(_lPt[_nL] <= 10)                                                                             return false;
-    if(!passTriggerEmulationDoubleEG(&lep, false))                                                  return false;
-    if(lep.gsfTrack()->hitPattern().numberOfLostHits(reco::HitPattern::MISSING_INNER_HITS) !=0)     return false;
-    double ptCone = _lPt[_nL];
-    if(_leptonMvaSUSY16[_nL] <= 0.5){
-        ptCone *= 0.85/_ptRatio[_nL];
+/*
+ * Cuts of one working point for lepton l, using only the lepton arrays (overlaps: ids of the muons overlapping with an electron)
+ */
+bool LeptonAnalyzer::passLeptonId(const LeptonIdCuts& cuts, const unsigned id, const unsigned l, const bool electron, const unsigned overlaps) const{
+    if(_lPt[l] <= cuts.minPt)                                        return false;
+    if(fabs(_lEta[l]) >= cuts.maxEta)                                return false;
+    if(fabs(_dxy[l]) >= cuts.maxDxy || fabs(_dz[l]) >= cuts.maxDz)  return false;
+    if(fabs(_3dIPSig[l]) >= cuts.max3dIPSig)                         return false;
+    if(_relIso[l] >= cuts.maxRelIso)                                 return false;
+    if(_miniIso[l] >= cuts.maxMiniIso)                               return false;
+    if(cuts.looseMuon  && !_lMuonIsLoose[l])                         return false;
+    if(cuts.mediumMuon && !_lMuonIsMedium[l])                        return false;
+    if(electron){
+        if(_lElectronMissingHits[l] > cuts.maxMissingHits)           return false;
+        if(cuts.convVeto && !_lElectronPassConvVeto[l])              return false;
+        if(cuts.triggerEmulation && !_lElectronPassEmu[l])           return false;
+        if(cuts.triggerEmulationNoHOverE && !_lElectronPassEmuNoHOverE[l]) return false;
+        if(!passElectronMva(cuts.electronMva, l))                    return false;
+        if(cuts.hOverEConePt != std::numeric_limits<double>::max()){
+            double ptCone = _lPt[l];
+            if(_leptonMvaSUSY16[l] <= cuts.minLeptonMva){
+                ptCone *= 0.85/_ptRatio[l];
+            }
+            if(ptCone >= cuts.hOverEConePt && !_lElectronPassHOverE[l])  return false;
+        }
+        if(cuts.muonOverlap && (overlaps & (1 << id)))               return false;        // Always run electrons after muons because of this
     }
-    if(ptCone >= 30 && lep.hadronicOverEm() >= (lep.isEB() ? 0.10  : 0.07) )                        return false;
-    return _leptonMvaSUSY16[_nL] > 0.5 || (passElectronMvaEwkFO(&lep, _lElectronMvaSummer16GP[_nL]) && _ptRatio[_nL] > 0.3 && _closestJetCsvV2[_nL] < 0.3);
+    if(_leptonMvaSUSY16[l] > cuts.minLeptonMva)                      return true;
+    return _ptRatio[l] > cuts.minPtRatio && _closestJetCsvV2[l] < cuts.maxClosestJetCsv && (!electron || passElectronMva(cuts.alternativeElectronMva, l));
 }
 
-bool LeptonAnalyzer::isEwkFO(const pat::Tau& tau) const{
-    return _lEwkLoose[_nL];
+/*
+ * All HN and ewkino ids for the muons or electrons at [first, first+n) in one pass, after the lepton MVAs
+ */
+void LeptonAnalyzer::computeLeptonIds(const unsigned first, const unsigned n, const bool electrons){
+    const LeptonIdCuts* cuts = electrons ? electronIdCuts : muonIdCuts;
+    for(unsigned l = first; l < first + n; ++l){
+        const unsigned overlaps = electrons ? muonOverlapIds(l) : 0;
+        for(unsigned id = 0; id < nLeptonIds; ++id){
+            leptonIdFlags[id][l] = (id == hnLoose || id == ewkLoose || leptonIdFlags[id - 1][l]) && passLeptonId(cuts[id], id, l, electrons, overlaps);
+        }
+    }
 }
 
-bool LeptonAnalyzer::isEwkTight(const pat::Muon& lep) const{
-    if(!_lEwkFO[_nL]) return false;
-    return _leptonMvaSUSY16[_nL] > -0.2;
+bool LeptonAnalyzer::isEwkLoose(const pat::Tau& tau) const{
+    if( _lPt[_nL] <= 20 || fabs(_lEta[_nL]) >= 2.3)     return false;
+    if(!_lPOGVeto[_nL])                                 return false;
+    if(!_tauEleVeto[_nL])                               return false;
+    return tauLightOverlap(_nL, _lEwkLoose);
 }
 
-bool LeptonAnalyzer::isEwkTight(const pat::Electron& lep) const{
-    if(!_lEwkFO[_nL])                       return false;
-    if(!passTriggerEmulationDoubleEG(&lep)) return false;
-    if(!lep.passConversionVeto())           return false;
-    return _leptonMvaSUSY16[_nL] > 0.5;
+bool LeptonAnalyzer::isEwkFO(const pat::Tau& tau, const unsigned l) const{
+    return _lEwkLoose[l];
 }
 
-bool LeptonAnalyzer::isEwkTight(const pat::Tau& tau) const{
-    return _lEwkFO[_nL] && _lPOGTight[_nL];
+bool LeptonAnalyzer::isEwkTight(const pat::Tau& tau, const unsigned l) const{
+    return _lEwkFO[l] && _lPOGTight[l];
 }
-
@@ -24,51 +24,68 @@ double LeptonAnalyzer::getRelIso03(const pat::Electron& ele, const double rho) c
 }
 
 
-double LeptonAnalyzer::getRelIso(const reco::RecoCandidate& ptcl, edm::Handle<pat::PackedCandidateCollection> pfcands,
-        double coneSize, double rho, const bool onlyCharged) const{
-    bool deltaBeta   = false;
+/*
+ * Single pass over the PF candidates around the lepton, accumulating the charged (PV), charged (PU), neutral hadron and photon sums for several cone sizes at once
+ * Within each cone the candidates are summed in the same order and with the same dead cones as a dedicated loop for that cone
+ */
+void LeptonAnalyzer::getIsolationSums(const reco::RecoCandidate& ptcl, const double* coneSizes, IsolationSums* sums, const unsigned nCones) const{
     double deadcone_nh(0.), deadcone_ch(0.), deadcone_ph(0.), deadcone_pu(0.);
     if(ptcl.isElectron() and fabs(ptcl.superCluster()->eta()) >1.479){ deadcone_ch = 0.015;  deadcone_pu = 0.015; deadcone_ph = 0.08; deadcone_nh = 0;}
     else if(ptcl.isMuon())                                           { deadcone_ch = 0.0001; deadcone_pu = 0.01;  deadcone_ph = 0.01; deadcone_nh = 0.01;}
 
-    double iso_nh(0.); double iso_ch(0.);
-    double iso_ph(0.); double iso_pu(0.);
     double ptThresh = ptcl.isElectron()? 0. : 0.5;
+    double maxConeSize = 0.;
+    for(unsigned c = 0; c < nCones; ++c){
+        sums[c] = IsolationSums();
+        maxConeSize = std::max(maxConeSize, coneSizes[c]);
+    }
 
-    for(const pat::PackedCandidate &pfc : *pfcands){
-        if(fabs(pfc.pdgId()) < 7) continue;
+    const PFCandidateGrid& grid = multilepAnalyzer->pfCandidateGrid;
+    std::vector<unsigned> candidatesInCone;                                                       // only loop over the candidates close to the lepton
+    grid.candidatesInCone(ptcl.eta(), ptcl.phi(), maxConeSize, candidatesInCone);
+    for(unsigned i : candidatesInCone){
+        const int pdgId = grid.absPdgId(i);
+        if(pdgId < 7) continue;
 
-        double dr = deltaR(pfc, ptcl);
-        if(dr > coneSize) continue;
+        double dr = deltaR(grid.eta(i), grid.phi(i), ptcl.eta(), ptcl.phi());
+        if(dr > maxConeSize) continue;
 
-        if(pfc.charge()==0){                                                                      // Neutral
-            if(pfc.pt()>ptThresh){
-                if(fabs(pfc.pdgId())==22 and dr > deadcone_ph)        iso_ph += pfc.pt(); // Photons
-                else if (fabs(pfc.pdgId())==130 and dr > deadcone_nh) iso_nh += pfc.pt(); // Neutral hadrons
+        double IsolationSums::* component = nullptr;                                              // which of the sums this candidate contributes to
+        if(grid.charge(i)==0){                                                                    // Neutral
+            if(grid.pt(i)>ptThresh){
+                if(pdgId==22 and dr > deadcone_ph)        component = &IsolationSums::ph;         // Photons
+                else if (pdgId==130 and dr > deadcone_nh) component = &IsolationSums::nh;         // Neutral hadrons
             }
-        } else if (pfc.fromPV()>1){
-            if(fabs(pfc.pdgId())==211 and dr > deadcone_ch) iso_ch += pfc.pt();           // Charged from PV
-        } else if(pfc.pt()>ptThresh and dr > deadcone_pu) iso_pu += pfc.pt();           // Charged from PU
+        } else if (grid.fromPV(i)>1){
+            if(pdgId==211 and dr > deadcone_ch) component = &IsolationSums::ch;                   // Charged from PV
+        } else if(grid.pt(i)>ptThresh and dr > deadcone_pu) component = &IsolationSums::pu;     // Charged from PU
+        if(!component) continue;
+
+        for(unsigned c = 0; c < nCones; ++c){
+            if(dr <= coneSizes[c]) sums[c].*component += grid.pt(i);
+        }
     }
+}
+
 
-    double puCorr = 0;
+double LeptonAnalyzer::getRelIso(const reco::RecoCandidate& ptcl, const IsolationSums& sums, double coneSize, double rho, const bool onlyCharged) const{
+    bool deltaBeta = false;
+    double puCorr  = 0;
     if(ptcl.isMuon()) puCorr = rho*muonsEffectiveAreas.getEffectiveArea(ptcl.eta());
     else              puCorr = rho*electronsEffectiveAreas.getEffectiveArea(ptcl.superCluster()->eta());
 
     double iso;
-    if(onlyCharged)    iso = iso_ch;
-    else if(deltaBeta) iso = iso_ch + std::max(0., iso_ph + iso_nh - 0.5*iso_pu);
-    else               iso = iso_ch + std::max(0., iso_ph + iso_nh - puCorr*(coneSize*coneSize)/(0.3*0.3));
+    if(onlyCharged)    iso = sums.ch;
+    else if(deltaBeta) iso = sums.ch + std::max(0., sums.ph + sums.nh - 0.5*sums.pu);
+    else               iso = sums.ch + std::max(0., sums.ph + sums.nh - puCorr*(coneSize*coneSize)/(0.3*0.3));
 
     return iso/ptcl.pt();
 }
 
 
-double LeptonAnalyzer::getMiniIsolation(const reco::RecoCandidate& ptcl, edm::Handle<pat::PackedCandidateCollection> pfcands,
-        double r_iso_min, double r_iso_max, double kt_scale, double rho, const bool onlyCharged) const{
-    //compute the miniIsolation cone
+//compute the miniIsolation cone
+double LeptonAnalyzer::getMiniIsoConeSize(const reco::RecoCandidate& ptcl, double r_iso_min, double r_iso_max, double kt_scale) const{
     double max_pt = kt_scale/r_iso_min;
     double min_pt = kt_scale/r_iso_max;
-    double r_iso  = kt_scale/std::max(std::min(ptcl.pt(), max_pt), min_pt);
-    return getRelIso(ptcl, pfcands, r_iso, rho, onlyCharged);
+    return kt_scale/std::max(std::min(ptcl.pt(), max_pt), min_pt);
 }
@@ -0,0 +1,338 @@
+#include "heavyNeutrino/multilep/interface/LeptonMvaForest.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Minimal reader for the TMVA xml weight files: only the tag names and attributes are needed
+ */
+namespace {
+    struct XmlTag {
+        std::string name;
+        std::string content;
+        bool        closing;                                                                             //</name>
+        bool        selfClosing;                                                                         //<name ... />
+
+        std::string attribute(const std::string& attributeName) const{
+            std::string key = " " + attributeName + "=\"";
+            size_t begin    = content.find(key);
+            if(begin == std::string::npos) throw cms::Exception("LeptonMvaForest") << "attribute " << attributeName << " missing in <" << name << ">";
+            begin      += key.size();
+            size_t end  = content.find('"', begin);
+            return decode(content.substr(begin, end - begin));
+        }
+
+        static std::string decode(std::string value){                                                   //replace the predefined xml entities
+            static const std::vector<std::pair<std::string, std::string>> entities = {{"&lt;", "<"}, {"&gt;", ">"}, {"&quot;", "\""}, {"&apos;", "'"}, {"&amp;", "&"}};
+            for(const auto& entity : entities){
+                for(size_t pos = value.find(entity.first); pos != std::string::npos; pos = value.find(entity.first, pos + 1)) value.replace(pos, entity.first.size(), entity.second);
+            }
+            return value;
+        }
+    };
+
+    std::vector<XmlTag> readTags(const std::string& xml){
+        std::vector<XmlTag> tags;
+        for(size_t begin = xml.find('<'); begin != std::string::npos; begin = xml.find('<', begin)){
+            size_t end = xml.find('>', begin);
+            if(end == std::string::npos) break;
+            XmlTag tag;
+            tag.content     = xml.substr(begin + 1, end - begin - 1);
+            tag.closing     = !tag.content.empty() and tag.content[0] == '/';
+            tag.selfClosing = !tag.content.empty() and tag.content.back() == '/';
+            size_t nameBegin = tag.closing ? 1 : 0;
+            tag.name        = tag.content.substr(nameBegin, tag.content.find_first_of(" />", nameBegin) - nameBegin);
+            tags.push_back(tag);
+            begin = end;
+        }
+        return tags;
+    }
+
+    std::string readFile(const std::string& fileName){
+        std::ifstream file(fileName, std::ios::binary);
+        if(!file) throw cms::Exception("LeptonMvaForest") << "can not open weight file " << fileName;
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        return buffer.str();
+    }
+
+    /*
+     * Binary cache: a fixed header followed by the flat arrays in native layout (4-byte arrays first, so they stay aligned in the mapping),
+     * and the variable expressions joined by newlines to check them without going back to the xml
+     * The key is a hash of the xml content, such that edits keeping the size and copies keeping the modification time are still detected
+     */
+    const char cacheMagic[8] = {'L', 'M', 'V', 'A', 'F', 'S', 'T', '3'};                               //bump the version when the layout changes
+
+    struct CacheHeader {
+        char     magic[8];
+        uint64_t xmlHash;
+        uint64_t xmlSize;
+        uint32_t variableCount;
+        uint32_t depth;
+        uint32_t nTrees;
+        uint32_t variableListSize;
+    };
+
+    uint64_t bodySize(const uint64_t nTrees, const uint64_t nInternals){
+        return nTrees*(nInternals*(sizeof(int) + sizeof(float) + 1) + (nInternals + 1)*sizeof(float));
+    }
+
+    uint64_t hashXml(const std::string& xml){                                                           //64-bit FNV-1a over 8-byte words, then the remaining bytes
+        uint64_t hash = 14695981039346656037ull;
+        size_t i = 0;
+        for(; i + sizeof(uint64_t) <= xml.size(); i += sizeof(uint64_t)){
+            uint64_t word;
+            std::memcpy(&word, xml.data() + i, sizeof(uint64_t));
+            hash ^= word;
+            hash *= 1099511628211ull;
+        }
+        for(; i < xml.size(); ++i){
+            hash ^= (unsigned char) xml[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+}
+
+
+LeptonMvaForest::LeptonMvaForest(const std::string& weightFileName, const std::vector<std::string>& variableNames, const Source source):
+    weightFile(weightFileName),
+    variableCount(variableNames.size()),
+    depth(0)
+{
+    for(const std::string& name : variableNames) variableList += name + '\n';
+    const std::string xml = readFile(weightFile);
+    xmlHash               = hashXml(xml);
+    xmlSize               = xml.size();
+    if(source == cacheOrXml and mapCache()) return;
+    readXml(xml, variableNames);
+}
+
+
+LeptonMvaForest::~LeptonMvaForest(){
+    if(mapping) munmap(mapping, mappingSize);
+}
+
+
+std::vector<std::string> LeptonMvaForest::xmlVariableNames(const std::string& weightFile){
+    std::vector<std::string> names;
+    for(const XmlTag& tag : readTags(readFile(weightFile))){
+        if(!tag.closing and tag.name == "Variable") names.push_back(tag.attribute("Expression"));
+    }
+    return names;
+}
+
+
+void LeptonMvaForest::readXml(const std::string& xml, const std::vector<std::string>& variableNames){
+    std::vector<XmlTag> tags = readTags(xml);
+    depth = 0;
+
+    // Check the input variables against the weight file
+    unsigned nFound = 0;
+    for(const XmlTag& tag : tags){
+        if(tag.closing or tag.name != "Variable") continue;
+        std::string expression = tag.attribute("Expression");
+        if(nFound >= variableNames.size() or expression != variableNames[nFound]){
+            throw cms::Exception("LeptonMvaForest") << "variable " << nFound << " in " << weightFile << " is " << expression
+                                                    << ", expected " << (nFound < variableNames.size() ? variableNames[nFound] : "none");
+        }
+        ++nFound;
+    }
+    if(nFound != variableNames.size()) throw cms::Exception("LeptonMvaForest") << weightFile << " has " << nFound << " variables, expected " << variableNames.size();
+
+    // Read the trees: nodes are written in pre-order, left before right, internal nodes have nType 0
+    std::vector<unsigned> roots;                                                                         //first node of each tree
+    std::vector<int>      variables;                                                                     //-1 for leaves
+    std::vector<float>    cuts;                                                                          //response for leaves
+    std::vector<bool>     cutTypes;
+    std::vector<unsigned> rights;
+    std::vector<unsigned> depths;
+    std::vector<unsigned> openNodes;                                                                     //internal nodes waiting for their right child
+    for(const XmlTag& tag : tags){
+        if(tag.closing or tag.name != "Node") continue;
+        unsigned index = variables.size();
+        bool internal  = std::atoi(tag.attribute("nType").c_str()) == 0;
+        std::string pos = tag.attribute("pos");
+
+        if(pos == "s"){
+            if(!openNodes.empty()) throw cms::Exception("LeptonMvaForest") << "incomplete tree in " << weightFile;
+            roots.push_back(index);
+            depths.push_back(0);
+        } else if(pos == "r"){
+            if(openNodes.empty()) throw cms::Exception("LeptonMvaForest") << "unexpected right node in " << weightFile;
+            rights[openNodes.back()] = index;
+            depths.push_back(depths[openNodes.back()] + 1);
+            openNodes.pop_back();
+        } else if(pos == "l" and index > 0 and variables.back() >= 0){
+            depths.push_back(depths.back() + 1);
+        } else {
+            throw cms::Exception("LeptonMvaForest") << "unexpected left node in " << weightFile;
+        }
+
+        variables.push_back(internal ? std::atoi(tag.attribute("IVar").c_str()) : -1);
+        cuts.push_back(std::strtof(tag.attribute(internal ? "Cut" : "res").c_str(), nullptr));
+        cutTypes.push_back(std::atoi(tag.attribute("cType").c_str()) == 1);
+        rights.push_back(0);
+        if(internal){
+            if(variables.back() >= (int) variableCount) throw cms::Exception("LeptonMvaForest") << "node uses unknown variable in " << weightFile;
+            openNodes.push_back(index);
+        }
+        depth = std::max(depth, depths.back());
+    }
+    if(roots.empty() or !openNodes.empty()) throw cms::Exception("LeptonMvaForest") << "no complete trees found in " << weightFile;
+
+    // Store every tree as a complete binary tree of the maximum depth (heap order), leaves above the maximum depth become nodes which always go left
+    nTrees     = roots.size();
+    nInternals = (1u << depth) - 1;
+    storage.assign((bodySize(nTrees, nInternals) + sizeof(int) - 1)/sizeof(int), 0);
+    setArrays((const char*) storage.data());
+    int*           treeVariables = const_cast<int*>(nodeVariables);
+    float*         treeCuts      = const_cast<float*>(nodeCuts);
+    float*         treeLeaves    = const_cast<float*>(leaves);
+    unsigned char* treeCutTypes  = const_cast<unsigned char*>(nodeCutTypes);
+    std::fill_n(treeCuts,     nTrees*nInternals, std::numeric_limits<float>::quiet_NaN());              //value >= NaN is false: cutType true goes left
+    std::fill_n(treeCutTypes, nTrees*nInternals, 1);
+
+    std::function<void(unsigned, unsigned, unsigned, unsigned)> place = [&](unsigned tree, unsigned node, unsigned heapIndex, unsigned level){
+        if(level == depth){
+            treeLeaves[tree*(nInternals + 1) + heapIndex - nInternals] = cuts[node];
+        } else if(variables[node] < 0){
+            place(tree, node, 2*heapIndex + 1, level + 1);
+            place(tree, node, 2*heapIndex + 2, level + 1);
+        } else {
+            treeVariables[tree*nInternals + heapIndex] = variables[node];
+            treeCuts[tree*nInternals + heapIndex]      = cuts[node];
+            treeCutTypes[tree*nInternals + heapIndex]  = cutTypes[node];
+            place(tree, node + 1,      2*heapIndex + 1, level + 1);
+            place(tree, rights[node], 2*heapIndex + 2, level + 1);
+        }
+    };
+    for(unsigned t = 0; t < nTrees; ++t) place(t, roots[t], 0, 0);
+}
+
+
+//Point the arrays into a block with the layout of the cache body
+void LeptonMvaForest::setArrays(const char* body){
+    const uint64_t nNodes = (uint64_t) nTrees*nInternals;
+    nodeVariables = (const int*)           body;
+    nodeCuts      = (const float*)         (body + nNodes*sizeof(int));
+    leaves        = (const float*)         (body + nNodes*(sizeof(int) + sizeof(float)));
+    nodeCutTypes  = (const unsigned char*) (body + nNodes*(sizeof(int) + sizeof(float)) + (nNodes + nTrees)*sizeof(float));
+}
+
+
+/*
+ * Map the cache read-only, and check it against the hash of the xml content: the arrays are then used directly from the mapping
+ * A missing cache is reported and the xml is parsed instead (e.g. makeLeptonMvaCache was not run after scram b)
+ * A cache which does not match the xml (stale or corrupt) throws: this is an installation problem which should not go unnoticed
+ * A cache for a different list of variables is rejected without error, such that reading the xml gives the usual error
+ */
+bool LeptonMvaForest::mapCache(){
+    const std::string cacheFile = weightFile + ".cache";
+    const int cache = open(cacheFile.c_str(), O_RDONLY);
+    if(cache < 0){
+        std::cerr << "LeptonMvaForest: no cache for " << weightFile << ", reading the xml (run makeLeptonMvaCache after compiling)" << std::endl;
+        return false;
+    }
+    struct stat cacheStat;
+    void* map = MAP_FAILED;
+    if(fstat(cache, &cacheStat) == 0 and (size_t) cacheStat.st_size >= sizeof(CacheHeader)) map = mmap(nullptr, cacheStat.st_size, PROT_READ, MAP_PRIVATE, cache, 0);
+    close(cache);
+    if(map == MAP_FAILED) throw cms::Exception("LeptonMvaForest") << "can not map " << cacheFile << ", rerun makeLeptonMvaCache";
+
+    const CacheHeader& header = *((const CacheHeader*) map);
+    const uint64_t nCachedInternals = (header.depth <= 20) ? (1ull << header.depth) - 1 : 0;
+    const char*    cachedList       = (const char*) map + sizeof(CacheHeader) + bodySize(header.nTrees, nCachedInternals);
+    bool matching   = std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) == 0 and header.xmlHash == xmlHash and header.xmlSize == xmlSize;
+    bool consistent = matching and header.depth <= 20 and header.nTrees > 0
+                      and (uint64_t) cacheStat.st_size == sizeof(CacheHeader) + bodySize(header.nTrees, nCachedInternals) + header.variableListSize;
+    if(!consistent){
+        munmap(map, cacheStat.st_size);
+        throw cms::Exception("LeptonMvaForest") << cacheFile << " does not match the content of " << weightFile << ", rerun makeLeptonMvaCache";
+    }
+    if(header.variableCount != variableCount or variableList.compare(0, std::string::npos, cachedList, header.variableListSize) != 0){
+        munmap(map, cacheStat.st_size);
+        return false;
+    }
+
+    mapping     = map;
+    mappingSize = cacheStat.st_size;
+    depth       = header.depth;
+    nTrees      = header.nTrees;
+    nInternals  = nCachedInternals;
+    setArrays((const char*) map + sizeof(CacheHeader));
+    if(std::all_of(nodeVariables, nodeVariables + (uint64_t) nTrees*nInternals, [this](int v){ return v >= 0 and v < (int) variableCount; })) return true;
+
+    munmap(mapping, mappingSize);
+    mapping = nullptr;
+    throw cms::Exception("LeptonMvaForest") << cacheFile << " is corrupt, rerun makeLeptonMvaCache";
+}
+
+
+/*
+ * Called at install time by bin/makeLeptonMvaCache, never during a job (the release area may be read-only, and grid jobs start from a fresh sandbox)
+ * Written to a temporary file first and renamed, such that a job never maps a partially written cache
+ */
+void LeptonMvaForest::writeCache() const{
+    CacheHeader header;
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.xmlHash          = xmlHash;
+    header.xmlSize          = xmlSize;
+    header.variableCount    = variableCount;
+    header.depth            = depth;
+    header.nTrees           = nTrees;
+    header.variableListSize = variableList.size();
+
+    const std::string cacheFile = weightFile + ".cache";
+    const std::string tmpFile   = cacheFile + ".tmp" + std::to_string(getpid());
+    std::ofstream file(tmpFile, std::ios::binary);
+    file.write((const char*) &header,        sizeof(header));
+    file.write((const char*) nodeVariables,  bodySize(nTrees, nInternals));
+    file.write(variableList.data(),          variableList.size());
+    file.close();
+    if(!file or std::rename(tmpFile.c_str(), cacheFile.c_str()) != 0){
+        std::remove(tmpFile.c_str());
+        throw cms::Exception("LeptonMvaForest") << "can not write " << cacheFile;
+    }
+}
+
+
+/*
+ * Batch evaluation: trees in the outer loop and leptons in the inner loop, such that the per-lepton sums are still made in the order of the trees
+ */
+void LeptonMvaForest::evaluate(const float* features, const unsigned nLeptons, double* mvas) const{
+    std::fill_n(mvas, nLeptons, 0.);
+    for(unsigned t = 0; t < nTrees; ++t){
+        const int*           treeVariables = nodeVariables + t*nInternals;
+        const float*         treeCuts      = nodeCuts      + t*nInternals;
+        const unsigned char* treeCutTypes  = nodeCutTypes  + t*nInternals;
+        const float*         treeLeaves    = leaves        + t*(nInternals + 1);
+        for(unsigned l = 0; l < nLeptons; ++l){
+            unsigned k = 0;
+            for(unsigned level = 0; level < depth; ++level){
+                bool goesRight = (features[treeVariables[k]*nLeptons + l] >= treeCuts[k]) == (bool) treeCutTypes[k];
+                k = 2*k + 1 + goesRight;
+            }
+            mvas[l] += treeLeaves[k - nInternals];
+        }
+    }
+
+    for(unsigned l = 0; l < nLeptons; ++l){
+        bool hasNaN = false;
+        for(unsigned v = 0; v < variableCount; ++v) hasNaN |= std::isnan(features[v*nLeptons + l]);
+        mvas[l] = hasNaN ? -999. : 2.0/(1.0 + exp(-2.0*mvas[l])) - 1;                                    //-999 for NaN inputs as TMVA::Reader
+    }
+}
@@ -1,139 +1,190 @@
 //implementation of LeptonMvaHelper class
 #include "heavyNeutrino/multilep/interface/LeptonMvaHelper.h"
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/Utilities/interface/Exception.h"
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <iomanip>
+#include <iostream>
 
 // TODO: clean-up of this class, maybe get rid of older trainings
 // the is2018 boolean is kind of useless currently, there's no 2018 training done yet
 
 //Default constructor
-//This will set up both MVA readers and book the correct variables
+//This will set up both MVA forests and book the correct variables
 LeptonMvaHelper::LeptonMvaHelper(const edm::ParameterSet& iConfig, const unsigned typeNumber, const bool sampleIs2017): //0 : SUSY , 1: ttH, 2: tZq/TTV
-    type(typeNumber), is2017(sampleIs2017), is2018(sampleIs2017)
+    type(typeNumber), is2017(sampleIs2017), is2018(sampleIs2017), validate(iConfig.getUntrackedParameter<bool>("validateLeptonMvas", false))
 {
-    for(unsigned i = 0; i < 2; ++i){
-        //Set up Mva reader 
-        reader[i] = std::make_shared<TMVA::Reader>( "!Color:!Silent");
-    }
     if(type < 2){
         for(unsigned i = 0; i < 2; ++i){
             //Book Common variables
-            reader[i]->AddVariable( "LepGood_pt", &LepGood_pt );
-            reader[i]->AddVariable( "LepGood_eta", &LepGood_eta );
-            reader[i]->AddVariable( "LepGood_jetNDauChargedMVASel", &LepGood_jetNDauChargedMVASel );
-            reader[i]->AddVariable( "LepGood_miniRelIsoCharged", &LepGood_miniRelIsoCharged );
-            reader[i]->AddVariable( "LepGood_miniRelIsoNeutral", &LepGood_miniRelIsoNeutral );
-            reader[i]->AddVariable( "LepGood_jetPtRelv2", &LepGood_jetPtRelv2 );
+            addVariable(i, "LepGood_pt", LeptonMvaFeatures::pt);
+            addVariable(i, "LepGood_eta", LeptonMvaFeatures::eta);
+            addVariable(i, "LepGood_jetNDauChargedMVASel", LeptonMvaFeatures::trackMult);
+            addVariable(i, "LepGood_miniRelIsoCharged", LeptonMvaFeatures::miniIsoCharged);
+            addVariable(i, "LepGood_miniRelIsoNeutral", LeptonMvaFeatures::miniIsoNeutral);
+            addVariable(i, "LepGood_jetPtRelv2", LeptonMvaFeatures::ptRel);
             if(  !(is2017 || is2018) ){
-                reader[i]->AddVariable( "min(LepGood_jetPtRatiov2,1.5)", &LepGood_jetPtRatio );
-                reader[i]->AddVariable( "max(LepGood_jetBTagCSV,0)", &LepGood_jetBTagCSV );
+                addVariable(i, "min(LepGood_jetPtRatiov2,1.5)", LeptonMvaFeatures::ptRatio);
+                addVariable(i, "max(LepGood_jetBTagCSV,0)", LeptonMvaFeatures::csv);
             } else{
-                reader[i]->AddVariable( "max(LepGood_jetBTagCSV,0)", &LepGood_jetBTagCSV );
-                reader[i]->AddVariable( "(LepGood_jetBTagCSV>-5)*min(LepGood_jetPtRatiov2,1.5)+(LepGood_jetBTagCSV<-5)/(1+LepGood_relIso04)", &LepGood_jetPtRatio);
+                addVariable(i, "max(LepGood_jetBTagCSV,0)", LeptonMvaFeatures::deepCsv);
+                addVariable(i, "(LepGood_jetBTagCSV>-5)*min(LepGood_jetPtRatiov2,1.5)+(LepGood_jetBTagCSV<-5)/(1+LepGood_relIso04)", LeptonMvaFeatures::ptRatioOrRelIso);
             }
-            reader[i]->AddVariable( "LepGood_sip3d", &LepGood_sip3d );
-            reader[i]->AddVariable( "log(abs(LepGood_dxy))", &LepGood_dxy );
-            reader[i]->AddVariable( "log(abs(LepGood_dz))", &LepGood_dz );
+            addVariable(i, "LepGood_sip3d", LeptonMvaFeatures::sip3d);
+            addVariable(i, "log(abs(LepGood_dxy))", LeptonMvaFeatures::logDxy);
+            addVariable(i, "log(abs(LepGood_dz))", LeptonMvaFeatures::logDz);
         }
 
         //Book specific muon variables
-        reader[0]->AddVariable("LepGood_segmentCompatibility", &LepGood_segmentCompatibility);
+        addVariable(0, "LepGood_segmentCompatibility", LeptonMvaFeatures::segmentCompatibility);
 
         if( !(is2017 || is2018) ){
             //Read Mva weights
             if(type == 0){ //SUSY weights used by default
                 //Book specific electron variables
-                reader[1]->AddVariable("LepGood_mvaIdSpring16GP", &LepGood_mvaIdSpring16GP);
+                addVariable(1, "LepGood_mvaIdSpring16GP", LeptonMvaFeatures::eleMvaSpring16GP);
             } else{
                 //Book specific electron variables
-                reader[1]->AddVariable("LepGood_mvaIdSpring16HZZ", &LepGood_mvaIdSpring16HZZ);
+                addVariable(1, "LepGood_mvaIdSpring16HZZ", LeptonMvaFeatures::eleMvaSpring16HZZ);
             }
         } else {
-            reader[1]->AddVariable("LepGood_mvaIdFall17noIso", &LepGood_mvaIdFall17noIso);
+            addVariable(1, "LepGood_mvaIdFall17noIso", LeptonMvaFeatures::eleMvaFall17);
         }
         if(type == 0){
-            reader[0]->BookMVA("BDTG method", iConfig.getParameter<edm::FileInPath>( std::string("leptonMvaWeightsMuSUSY") + ( (is2017 || is2018)? "17" : "16") ).fullPath());
-            reader[1]->BookMVA("BDTG method", iConfig.getParameter<edm::FileInPath>( std::string("leptonMvaWeightsEleSUSY") + ((is2017 || is2018) ? "17" : "16") ).fullPath());
+            bookMva(0, iConfig.getParameter<edm::FileInPath>( std::string("leptonMvaWeightsMuSUSY") + ( (is2017 || is2018)? "17" : "16") ).fullPath());
+            bookMva(1, iConfig.getParameter<edm::FileInPath>( std::string("leptonMvaWeightsEleSUSY") + ((is2017 || is2018) ? "17" : "16") ).fullPath());
         } else{
-            reader[0]->BookMVA("BDTG method", iConfig.getParameter<edm::FileInPath>( std::string("leptonMvaWeightsMuttH") + ((is2017 || is2018) ? "17" : "16") ).fullPath());
-            reader[1]->BookMVA("BDTG method", iConfig.getParameter<edm::FileInPath>( std::string("leptonMvaWeightsElettH") + ((is2017 || is2018) ? "17" : "16") ).fullPath());
+            bookMva(0, iConfig.getParameter<edm::FileInPath>( std::string("leptonMvaWeightsMuttH") + ((is2017 || is2018) ? "17" : "16") ).fullPath());
+            bookMva(1, iConfig.getParameter<edm::FileInPath>( std::string("leptonMvaWeightsElettH") + ((is2017 || is2018) ? "17" : "16") ).fullPath());
         }
     } else{
         for(unsigned i = 0; i < 2; ++i){
-            reader[i]->AddVariable( "pt", &LepGood_pt );
-            reader[i]->AddVariable( "eta", &LepGood_eta );
-            reader[i]->AddVariable( "trackMultClosestJet", &LepGood_jetNDauChargedMVASel );
-            reader[i]->AddVariable( "miniIsoCharged", &LepGood_miniRelIsoCharged );
-            reader[i]->AddVariable( "miniIsoNeutral", &LepGood_miniRelIsoNeutral );
-            reader[i]->AddVariable( "pTRel", &LepGood_jetPtRelv2 );
-            reader[i]->AddVariable( "ptRatio", &LepGood_jetPtRatio );
-            reader[i]->AddVariable( "relIso", &LepGood_relIso0p3); 
-            reader[i]->AddVariable( "deepCsvClosestJet", &LepGood_jetBTagCSV );
-            reader[i]->AddVariable( "sip3d", &LepGood_sip3d );
-            reader[i]->AddVariable( "dxy", &LepGood_dxy);
-            reader[i]->AddVariable( "dz", &LepGood_dz);
+            addVariable(i, "pt", LeptonMvaFeatures::pt);
+            addVariable(i, "eta", LeptonMvaFeatures::absEta);
+            addVariable(i, "trackMultClosestJet", LeptonMvaFeatures::trackMult);
+            addVariable(i, "miniIsoCharged", LeptonMvaFeatures::miniIsoCharged);
+            addVariable(i, "miniIsoNeutral", LeptonMvaFeatures::miniIsoNeutral);
+            addVariable(i, "pTRel", LeptonMvaFeatures::ptRel);
+            addVariable(i, "ptRatio", LeptonMvaFeatures::ptRatio);
+            addVariable(i, "relIso", LeptonMvaFeatures::relIso0p3);
+            addVariable(i, "deepCsvClosestJet", LeptonMvaFeatures::deepCsv);
+            addVariable(i, "sip3d", LeptonMvaFeatures::sip3d);
+            addVariable(i, "dxy", LeptonMvaFeatures::logDxy);
+            addVariable(i, "dz", LeptonMvaFeatures::logDz);
         }
-        reader[0]->AddVariable("segmentCompatibility", &LepGood_segmentCompatibility);
+        addVariable(0, "segmentCompatibility", LeptonMvaFeatures::segmentCompatibility);
         if(  !(is2017 || is2018)  ){
-            reader[1]->AddVariable("electronMvaSpring16GP", &LepGood_mvaIdSpring16GP);
+            addVariable(1, "electronMvaSpring16GP", LeptonMvaFeatures::eleMvaSpring16GP);
         } else{
-            reader[1]->AddVariable("electronMvaFall17NoIso", &LepGood_mvaIdFall17noIso);
+            addVariable(1, "electronMvaFall17NoIso", LeptonMvaFeatures::eleMvaFall17);
         }
         if(  !(is2017 || is2018)  ){
-            reader[0]->BookMVA("BDTG method", iConfig.getParameter<edm::FileInPath>("leptonMvaWeightsMutZqTTV16").fullPath());
-            reader[1]->BookMVA("BDTG method", iConfig.getParameter<edm::FileInPath>("leptonMvaWeightsEletZqTTV16").fullPath());
+            bookMva(0, iConfig.getParameter<edm::FileInPath>("leptonMvaWeightsMutZqTTV16").fullPath());
+            bookMva(1, iConfig.getParameter<edm::FileInPath>("leptonMvaWeightsEletZqTTV16").fullPath());
         } else{
-            reader[0]->BookMVA("BDTG method", iConfig.getParameter<edm::FileInPath>("leptonMvaWeightsMutZqTTV17").fullPath());
-            reader[1]->BookMVA("BDTG method", iConfig.getParameter<edm::FileInPath>("leptonMvaWeightsEletZqTTV17").fullPath());
+            bookMva(0, iConfig.getParameter<edm::FileInPath>("leptonMvaWeightsMutZqTTV17").fullPath());
+            bookMva(1, iConfig.getParameter<edm::FileInPath>("leptonMvaWeightsEletZqTTV17").fullPath());
         }
     }
 }
-void LeptonMvaHelper::bookCommonVars(double pt, double eta, double selectedTrackMult, double miniIsoCharged, double miniIsoNeutral, double ptRel, double ptRatio, 
-    double closestJetCsv, double closestJetDeepCsv, double sip3d, double dxy, double dz, double relIso0p3, double relIso0p4)
+
+//Transformations of the inputs as done by the trainings, the 2016 SUSY and ttH trainings use the CSVv2 b-tag, all others deepCSV
+void LeptonMvaFeatures::add(double pt, double eta, double selectedTrackMult, double miniIsoCharged, double miniIsoNeutral, double ptRel, double ptRatio,
+    double closestJetCsv, double closestJetDeepCsv, double sip3d, double dxy, double dz, double relIso0p3, double relIso0p4, double segComp, double eleMvaSpring16, double eleMvaHZZ, double eleMvaFall17)
 {
-    LepGood_pt = pt;
-    if(type >= 2){
-        LepGood_eta = fabs(eta);
-    } else{
-        LepGood_eta = eta;
-    }
-    LepGood_jetNDauChargedMVASel = selectedTrackMult;
-    LepGood_miniRelIsoCharged = miniIsoCharged;
-    LepGood_miniRelIsoNeutral = miniIsoNeutral;
-    LepGood_jetPtRelv2 = ptRel;
-    LepGood_jetPtRatio = std::min(ptRatio, 1.5);
-    if( is2017 || is2018 || type  >= 2){
-        LepGood_jetBTagCSV = std::max( (std::isnan(closestJetDeepCsv) ? 0. : closestJetDeepCsv) , 0.);
-    } else{
-        LepGood_jetBTagCSV = std::max(closestJetCsv, 0.);
-    }
-    LepGood_relIso0p4 = relIso0p4;
     //use relIso for closest jet when no close jet for 2017 SUSY and ttH mvas
-    if( (is2017 || is2018) && type < 2){
-        LepGood_jetPtRatio = 1 + relIso0p4;
-        bool goodBTag = (closestJetDeepCsv > -5.) || !std::isnan(closestJetDeepCsv);
-        LepGood_jetPtRatio = goodBTag*std::min(ptRatio, 1.5) + (!goodBTag)/(1 + relIso0p4);
+    bool goodBTag = (closestJetDeepCsv > -5.) || !std::isnan(closestJetDeepCsv);
+
+    columns[Feature::pt].push_back(pt);
+    columns[Feature::eta].push_back(eta);
+    columns[Feature::absEta].push_back(fabs(eta));
+    columns[Feature::trackMult].push_back(selectedTrackMult);
+    columns[Feature::miniIsoCharged].push_back(miniIsoCharged);
+    columns[Feature::miniIsoNeutral].push_back(miniIsoNeutral);
+    columns[Feature::ptRel].push_back(ptRel);
+    columns[Feature::ptRatio].push_back(std::min(ptRatio, 1.5));
+    columns[Feature::ptRatioOrRelIso].push_back(goodBTag*std::min(ptRatio, 1.5) + (!goodBTag)/(1 + relIso0p4));
+    columns[Feature::csv].push_back(std::max(closestJetCsv, 0.));
+    columns[Feature::deepCsv].push_back(std::max( (std::isnan(closestJetDeepCsv) ? 0. : closestJetDeepCsv) , 0.));
+    columns[Feature::sip3d].push_back(sip3d);
+    columns[Feature::logDxy].push_back(log(fabs(dxy)));
+    columns[Feature::logDz].push_back(log(fabs(dz)));
+    columns[Feature::relIso0p3].push_back(relIso0p3);
+    columns[Feature::segmentCompatibility].push_back(segComp);
+    columns[Feature::eleMvaSpring16GP].push_back(eleMvaSpring16);
+    columns[Feature::eleMvaSpring16HZZ].push_back(eleMvaHZZ);
+    columns[Feature::eleMvaFall17].push_back(eleMvaFall17);
+}
+
+void LeptonMvaHelper::leptonMvaMuons(const LeptonMvaFeatures& features, double* mvas) const{
+    evaluateMva(0, features, mvas);
+}
+
+void LeptonMvaHelper::leptonMvaElectrons(const LeptonMvaFeatures& features, double* mvas) const{
+    evaluateMva(1, features, mvas);
+}
+
+//Register a variable, in the order of the weight file
+void LeptonMvaHelper::addVariable(const unsigned i, const std::string& expression, const LeptonMvaFeatures::Feature feature){
+    variableNames[i].push_back(expression);
+    variables[i].push_back(feature);
+}
+
+void LeptonMvaHelper::bookMva(const unsigned i, const std::string& weightFile){
+    forest[i]      = std::make_shared<const LeptonMvaForest>(weightFile, variableNames[i]);
+    weightFiles[i] = weightFile;
+    if(!validate) return;
+
+    //the reader keeps pointers to its inputs, so they are sized once before booking
+    reader[i].reset(new TMVA::Reader("!Color:Silent"));
+    readerInputs[i].resize(variableNames[i].size());
+    for(unsigned v = 0; v < variableNames[i].size(); ++v) reader[i]->AddVariable(variableNames[i][v], &readerInputs[i][v]);
+    reader[i]->BookMVA("BDTG method", weightFile);
+}
+
+LeptonMvaHelper::~LeptonMvaHelper(){
+    for(unsigned i = 0; i < 2; ++i){
+        if(!validate or nValidated[i] == 0) continue;
+        std::cout << "LeptonMvaHelper: " << weightFiles[i] << ": " << nValidated[i] << " leptons identical to TMVA::Reader, "
+                  << std::setprecision(3) << 1e6*nativeTime[i]/nValidated[i] << " us/lepton (native) vs "
+                  << 1e6*readerTime[i]/nValidated[i] << " us/lepton (TMVA::Reader)" << std::endl;
     }
-    LepGood_sip3d = sip3d;
-    LepGood_dxy = log(fabs(dxy));
-    LepGood_dz = log(fabs(dz));
-    LepGood_relIso0p3 = relIso0p3;
 }
 
-double LeptonMvaHelper::leptonMvaMuon(double pt, double eta, double selectedTrackMult, double miniIsoCharged, double miniIsoNeutral, double ptRel, double ptRatio, 
-    double closestJetCsv, double closestJetDeepCsv, double sip3d, double dxy, double dz, double relIso0p3, double relIso0p4, double segComp)
-{
-    bookCommonVars(pt, eta, selectedTrackMult, miniIsoCharged, miniIsoNeutral, ptRel, ptRatio, closestJetCsv, closestJetDeepCsv, sip3d, dxy, dz, relIso0p3, relIso0p4);
-    LepGood_segmentCompatibility = segComp;
-    return reader[0]->EvaluateMVA("BDTG method");
+//Collect the features used by this training in one matrix and evaluate all leptons at once
+void LeptonMvaHelper::evaluateMva(const unsigned i, const LeptonMvaFeatures& features, double* mvas) const{
+    const unsigned nLeptons = features.size();
+    if(nLeptons == 0) return;
+    std::vector<float> matrix(variables[i].size()*nLeptons);
+    for(unsigned v = 0; v < variables[i].size(); ++v) std::copy_n(features.column(variables[i][v]), nLeptons, matrix.begin() + v*nLeptons);
+    if(!validate){
+        forest[i]->evaluate(matrix.data(), nLeptons, mvas);
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    forest[i]->evaluate(matrix.data(), nLeptons, mvas);
+    validateMva(i, matrix.data(), nLeptons, mvas, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
 }
 
-double LeptonMvaHelper::leptonMvaElectron(double pt, double eta, double selectedTrackMult, double miniIsoCharged, double miniIsoNeutral, double ptRel, double ptRatio, 
-    double closestJetCsv, double closestJetDeepCsv, double sip3d, double dxy, double dz, double relIso0p3, double relIso0p4, double eleMvaSpring16, double eleMvaHZZ, double eleMvaFall17)
-{
-    bookCommonVars(pt, eta, selectedTrackMult, miniIsoCharged, miniIsoNeutral, ptRel, ptRatio, closestJetCsv, closestJetDeepCsv, sip3d, dxy, dz, relIso0p3, relIso0p4);
-    LepGood_mvaIdSpring16GP = eleMvaSpring16;
-    LepGood_mvaIdSpring16HZZ = eleMvaHZZ;
-    LepGood_mvaIdFall17noIso = eleMvaFall17;
-    return reader[1]->EvaluateMVA("BDTG method");
+//Bitwise comparison with TMVA::Reader::EvaluateMVA, any difference stops the job
+void LeptonMvaHelper::validateMva(const unsigned i, const float* matrix, const unsigned nLeptons, const double* mvas, const double evaluationTime) const{
+    std::lock_guard<std::mutex> lock(validationMutex);
+    const unsigned nVariables = readerInputs[i].size();
+    auto start = std::chrono::steady_clock::now();
+    for(unsigned l = 0; l < nLeptons; ++l){
+        for(unsigned v = 0; v < nVariables; ++v) readerInputs[i][v] = matrix[v*nLeptons + l];
+        double readerMva = reader[i]->EvaluateMVA("BDTG method");
+        if(readerMva != mvas[l]){
+            cms::Exception exception("LeptonMvaHelper");
+            exception << "native forest and TMVA::Reader differ for " << weightFiles[i] << ": " << std::setprecision(17) << mvas[l] << " vs " << readerMva << ", inputs:";
+            for(unsigned v = 0; v < nVariables; ++v) exception << " " << variableNames[i][v] << "=" << readerInputs[i][v];
+            throw exception;
+        }
+    }
+    readerTime[i] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    nativeTime[i] += evaluationTime;
+    nValidated[i] += nLeptons;
 }
@@ -10,20 +10,24 @@
  * Also saving the ctau of the heavy neutrino
  * If the storeLheParticles boolean is set, most of the LHE particle information is stored to the tree
  * Also keeping track of LHE taus in the event [to be used in case this is run on a sample where pythia decays all taus leptonically]
+ * The event counters are only booked and filled by the counter instance of multilep (running on all events), the branches only by the ntuplizer
  */
 LheAnalyzer::LheAnalyzer(const edm::ParameterSet& iConfig, multilep* multilepAnalyzer):
     multilepAnalyzer(multilepAnalyzer)
 {};
 
 
-void LheAnalyzer::beginJob(TTree* outputTree, edm::Service<TFileService>& fs){
+void LheAnalyzer::beginJob(TTree* outputTree, const OutputMerger& outputMerger){
     if(multilepAnalyzer->isData) return;
-    hCounter   = fs->make<TH1D>("hCounter",   "Events counter", 1, 0, 1);
-    lheCounter = fs->make<TH1D>("lheCounter", "Lhe weights",    110, 0, 110); //Counter to determine effect of pdf and scale uncertainties on the MC cross section
-    psCounter  = fs->make<TH1D>("psCounter",  "Lhe weights",    14, 0, 14);
-    tauCounter = fs->make<TH1D>("tauCounter", "Number of taus", 3, 0, 3);
+    if(multilepAnalyzer->countersOnly){
+        hCounter   = outputMerger.make<TH1D>("hCounter",   "Events counter", 1, 0, 1);
+        lheCounter = outputMerger.make<TH1D>("lheCounter", "Lhe weights",    110, 0, 110); //Counter to determine effect of pdf and scale uncertainties on the MC cross section
+        psCounter  = outputMerger.make<TH1D>("psCounter",  "Lhe weights",    14, 0, 14);
+        tauCounter = outputMerger.make<TH1D>("tauCounter", "Number of taus", 3, 0, 3);
 
-    nTrueInteractions = fs->make<TH1D>("nTrueInteractions", "nTrueInteractions", 100, 0, 100);
+        nTrueInteractions = outputMerger.make<TH1D>("nTrueInteractions", "nTrueInteractions", 100, 0, 100);
+        return;
+    }
 
     outputTree->Branch("_nTrueInt",      &_nTrueInt,      "_nTrueInt/F");
     outputTree->Branch("_weight",        &_weight,        "_weight/D");
@@ -58,8 +62,11 @@ void LheAnalyzer::analyze(const edm::Event& iEvent){
 
     _nTrueInt = pileUpInfo->begin()->getTrueNumInteractions(); // getTrueNumInteractions is the same for all bunch crossings
     _weight   = genEventInfo->weight();
-    hCounter->Fill(0.5, _weight);
-    nTrueInteractions->Fill(_nTrueInt, _weight);
+    const bool fillCounters = multilepAnalyzer->countersOnly;
+    if(fillCounters){
+        hCounter->Fill(0.5, _weight);
+        nTrueInteractions->Fill(_nTrueInt, _weight);
+    }
 
     _lheHTIncoming = 0.;
     _ctauHN = 0.;
@@ -96,13 +103,13 @@ void LheAnalyzer::analyze(const edm::Event& iEvent){
         if(abs(_lhePdgId[i])==15) ++_nTau;
     }
 
-    tauCounter->Fill(_nTau, _weight);
+    if(fillCounters) tauCounter->Fill(_nTau, _weight);
 
     //Store LHE weights to compute pdf and scale uncertainties, as described on https://twiki.cern.ch/twiki/bin/viewauth/CMS/LHEReaderCMSSW
     _nLheWeights = std::min( (unsigned) 110, (unsigned) lheEventInfo->weights().size()); // 110 for MC@NLO, 254 for powheg, 446(!) for madgraph, 0 for some old samples,...
     for(unsigned i = 0; i < _nLheWeights; ++i){
         _lheWeight[i] = lheEventInfo->weights()[i].wgt/lheEventInfo->originalXWGTUP();
-        lheCounter->Fill(i + 0.5, _lheWeight[i]*_weight);
+        if(fillCounters) lheCounter->Fill(i + 0.5, _lheWeight[i]*_weight);
     }
 
     //some tests for PS weight extraction
@@ -110,7 +117,7 @@ void LheAnalyzer::analyze(const edm::Event& iEvent){
     _nPsWeights = std::min( (unsigned) 14, (unsigned) psWeights.size() );
     for(unsigned ps = 0; ps < _nPsWeights; ++ps){
         _psWeight[ps] = psWeights[ps]/_weight;
-        psCounter->Fill(ps + 0.5, _psWeight[ps]*_weight);
+        if(fillCounters) psCounter->Fill(ps + 0.5, _psWeight[ps]*_weight);
     }
 }
 
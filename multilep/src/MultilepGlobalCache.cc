@@ -0,0 +1,29 @@
+#include "heavyNeutrino/multilep/interface/MultilepGlobalCache.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <algorithm>
+#include <tuple>
+
+MultilepGlobalCache::MultilepGlobalCache(const edm::ParameterSet& iConfig, TDirectory* directory):
+    outputMerger(directory)
+{
+    //name (as in the leptonMvas parameter), type (0: SUSY, 1: ttH, 2: tZq/TTV) and whether it is the 2017 training
+    static const std::vector<std::tuple<std::string, unsigned, bool>> trainings = {{"SUSY16",   0, false}, {"TTH16",    1, false},
+                                                                                   {"SUSY17",   0, true},  {"TTH17",    1, true},
+                                                                                   {"tZqTTV16", 2, false}, {"tZqTTV17", 2, true}};
+
+    if(iConfig.getUntrackedParameter<bool>("countersOnly", false)) return;                              //the counter instance does not evaluate leptons
+
+    std::vector<std::string> leptonMvas = iConfig.getParameter<std::vector<std::string>>("leptonMvas");
+    for(const std::string& name : leptonMvas){
+        if(std::none_of(trainings.begin(), trainings.end(), [&name](const std::tuple<std::string, unsigned, bool>& training){ return std::get<0>(training) == name; })){
+            throw cms::Exception("MultilepGlobalCache") << "unknown lepton MVA " << name << " in leptonMvas";
+        }
+    }
+    leptonMvas.push_back("SUSY16");
+    for(const auto& training : trainings){
+        const std::string& name = std::get<0>(training);
+        if(std::find(leptonMvas.begin(), leptonMvas.end(), name) == leptonMvas.end()) continue;
+        leptonMvaHelpers[name] = std::make_shared<const LeptonMvaHelper>(iConfig, std::get<1>(training), std::get<2>(training));
+    }
+}
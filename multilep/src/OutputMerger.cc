@@ -0,0 +1,69 @@
+#include "heavyNeutrino/multilep/interface/OutputMerger.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "TObjArray.h"
+
+#include <limits>
+
+OutputMerger::OutputMerger(TDirectory* directory):
+    directory(directory),
+    lastStream(std::numeric_limits<unsigned>::max())
+{};
+
+
+/*
+ * The output tree is booked with the same branch names and leaf lists as the first registered stream tree
+ * All later streams should have exactly the same layout, only the addresses of their buffers are stored
+ */
+void OutputMerger::registerTree(const edm::StreamID stream, TTree* streamTree) const{
+    std::lock_guard<std::mutex> lock(mutex);
+    TObjArray* streamBranches = streamTree->GetListOfBranches();
+
+    if(!outputTree){
+      TDirectory::TContext context(directory);
+      outputTree = new TTree(streamTree->GetName(), streamTree->GetTitle());
+      outputTree->SetDirectory(directory);
+      for(int b = 0; b < streamBranches->GetEntriesFast(); ++b){
+        TBranch* branch = static_cast<TBranch*>(streamBranches->UncheckedAt(b));
+        outputTree->Branch(branch->GetName(), branch->GetAddress(), branch->GetTitle());
+      }
+    }
+
+    if(streamBranches->GetEntriesFast() != outputTree->GetListOfBranches()->GetEntriesFast()){
+      throw cms::Exception("OutputMerger") << "tree of stream " << stream.value() << " has " << streamBranches->GetEntriesFast()
+                                           << " branches while the output tree has " << outputTree->GetListOfBranches()->GetEntriesFast();
+    }
+
+    if(streamAddresses.size() <= stream.value()) streamAddresses.resize(stream.value() + 1);
+    auto& addresses = streamAddresses[stream.value()];
+    addresses.clear();
+    for(int b = 0; b < streamBranches->GetEntriesFast(); ++b){
+      TBranch* branch       = static_cast<TBranch*>(streamBranches->UncheckedAt(b));
+      TBranch* outputBranch = outputTree->GetBranch(branch->GetName());
+      if(!outputBranch or std::string(outputBranch->GetTitle()) != branch->GetTitle()){
+        throw cms::Exception("OutputMerger") << "branch " << branch->GetName() << " of stream " << stream.value() << " does not match the output tree";
+      }
+      addresses.emplace_back(outputBranch, branch->GetAddress());
+    }
+    if(lastStream == stream.value()) lastStream = std::numeric_limits<unsigned>::max();
+}
+
+
+void OutputMerger::fill(const edm::StreamID stream) const{
+    std::lock_guard<std::mutex> lock(mutex);
+    if(lastStream != stream.value()){
+      for(auto& branchAndAddress : streamAddresses[stream.value()]) branchAndAddress.first->SetAddress(branchAndAddress.second);
+      lastStream = stream.value();
+    }
+    outputTree->Fill();
+}
+
+
+void OutputMerger::merge() const{
+    std::lock_guard<std::mutex> lock(mutex);
+    for(auto& histogram : histograms){
+      for(auto& streamHistogram : histogram.streams) histogram.output->Add(streamHistogram.get());
+    }
+    if(outputTree) outputTree->ResetBranchAddresses();                                                   //stream buffers are gone after the job, the tree itself is written by the TFileService
+    lastStream = std::numeric_limits<unsigned>::max();
+}
@@ -0,0 +1,151 @@
+#include "heavyNeutrino/multilep/interface/PFCandidateGrid.h"
+
+#include "TMath.h"
+
+#include <algorithm>
+#include <cmath>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+/*
+ * Cone kernels: append the slots in [begin, end) with deltaR^2 <= maxDeltaR2 to the slots vector
+ * They only serve as a prefilter (with a margin on maxDeltaR2), the exact deltaR cut is applied by the callers on the returned candidates
+ */
+namespace {
+    typedef void (*ConeKernel)(const double*, const double*, unsigned, unsigned, double, double, double, std::vector<unsigned>&);
+
+    void coneKernelScalar(const double* eta, const double* phi, unsigned begin, const unsigned end, const double eta0, const double phi0,
+            const double maxDeltaR2, std::vector<unsigned>& slots){
+        for(unsigned i = begin; i < end; ++i){
+            double dEta = eta[i] - eta0;
+            double dPhi = phi[i] - phi0;
+            if(dPhi > TMath::Pi())       dPhi -= TMath::TwoPi();
+            else if(dPhi < -TMath::Pi()) dPhi += TMath::TwoPi();
+            if(dEta*dEta + dPhi*dPhi <= maxDeltaR2) slots.push_back(i);
+        }
+    }
+
+#if defined(__x86_64__)
+    void coneKernelSSE2(const double* eta, const double* phi, unsigned begin, const unsigned end, const double eta0, const double phi0,
+            const double maxDeltaR2, std::vector<unsigned>& slots){
+        const __m128d vEta0 = _mm_set1_pd(eta0),      vPhi0  = _mm_set1_pd(phi0), vMax = _mm_set1_pd(maxDeltaR2);
+        const __m128d vPi   = _mm_set1_pd(TMath::Pi()), vMinPi = _mm_set1_pd(-TMath::Pi()), vTwoPi = _mm_set1_pd(TMath::TwoPi());
+        for(; begin + 2 <= end; begin += 2){
+            __m128d dEta = _mm_sub_pd(_mm_loadu_pd(eta + begin), vEta0);
+            __m128d dPhi = _mm_sub_pd(_mm_loadu_pd(phi + begin), vPhi0);
+            dPhi = _mm_sub_pd(dPhi, _mm_and_pd(_mm_cmpgt_pd(dPhi, vPi), vTwoPi));
+            dPhi = _mm_add_pd(dPhi, _mm_and_pd(_mm_cmplt_pd(dPhi, vMinPi), vTwoPi));
+            __m128d dR2 = _mm_add_pd(_mm_mul_pd(dEta, dEta), _mm_mul_pd(dPhi, dPhi));
+            int mask = _mm_movemask_pd(_mm_cmple_pd(dR2, vMax));
+            if(mask & 1) slots.push_back(begin);
+            if(mask & 2) slots.push_back(begin + 1);
+        }
+        coneKernelScalar(eta, phi, begin, end, eta0, phi0, maxDeltaR2, slots);
+    }
+
+    __attribute__((target("avx2")))
+    void coneKernelAVX2(const double* eta, const double* phi, unsigned begin, const unsigned end, const double eta0, const double phi0,
+            const double maxDeltaR2, std::vector<unsigned>& slots){
+        const __m256d vEta0 = _mm256_set1_pd(eta0),      vPhi0  = _mm256_set1_pd(phi0), vMax = _mm256_set1_pd(maxDeltaR2);
+        const __m256d vPi   = _mm256_set1_pd(TMath::Pi()), vMinPi = _mm256_set1_pd(-TMath::Pi()), vTwoPi = _mm256_set1_pd(TMath::TwoPi());
+        for(; begin + 4 <= end; begin += 4){
+            __m256d dEta = _mm256_sub_pd(_mm256_loadu_pd(eta + begin), vEta0);
+            __m256d dPhi = _mm256_sub_pd(_mm256_loadu_pd(phi + begin), vPhi0);
+            dPhi = _mm256_sub_pd(dPhi, _mm256_and_pd(_mm256_cmp_pd(dPhi, vPi, _CMP_GT_OQ), vTwoPi));
+            dPhi = _mm256_add_pd(dPhi, _mm256_and_pd(_mm256_cmp_pd(dPhi, vMinPi, _CMP_LT_OQ), vTwoPi));
+            __m256d dR2 = _mm256_add_pd(_mm256_mul_pd(dEta, dEta), _mm256_mul_pd(dPhi, dPhi));
+            int mask = _mm256_movemask_pd(_mm256_cmp_pd(dR2, vMax, _CMP_LE_OQ));
+            while(mask){                                                                                 //lowest bits first, keeps the order
+                slots.push_back(begin + __builtin_ctz(mask));
+                mask &= mask - 1;
+            }
+        }
+        coneKernelScalar(eta, phi, begin, end, eta0, phi0, maxDeltaR2, slots);
+    }
+#endif
+
+    ConeKernel selectConeKernel(){
+#if defined(__x86_64__)
+        if(__builtin_cpu_supports("avx2")) return coneKernelAVX2;
+        return coneKernelSSE2;                                                                           //SSE2 is always available on x86-64
+#else
+        return coneKernelScalar;
+#endif
+    }
+}
+
+
+PFCandidateGrid::PFCandidateGrid():
+    cellOffsets(nEtaCells*nPhiCells + 1, 0)
+{};
+
+
+int PFCandidateGrid::etaCell(const double eta) const{
+    int cell = (int) std::floor((eta + etaMax)*nEtaCells/(2*etaMax));
+    return std::min(std::max(cell, 0), (int) nEtaCells - 1);
+}
+
+int PFCandidateGrid::phiCell(const double phi) const{
+    return (int) std::floor((phi + TMath::Pi())*nPhiCells/(2*TMath::Pi()));
+}
+
+
+/*
+ * Counting sort of the candidates over the cells, keeping the original order within each cell
+ * The packed candidate accessors are only called here, once per candidate
+ */
+void PFCandidateGrid::fill(const std::vector<pat::PackedCandidate>& pfcands){
+    const unsigned nCands = pfcands.size();
+    std::vector<unsigned> cells(nCands);
+    std::fill(cellOffsets.begin(), cellOffsets.end(), 0);
+    for(unsigned i = 0; i < nCands; ++i){
+        int phi  = phiCell(pfcands[i].phi()) % (int) nPhiCells;
+        if(phi < 0) phi += nPhiCells;
+        cells[i] = etaCell(pfcands[i].eta())*nPhiCells + phi;
+        ++cellOffsets[cells[i] + 1];
+    }
+    for(unsigned c = 0; c < nEtaCells*nPhiCells; ++c) cellOffsets[c + 1] += cellOffsets[c];
+
+    indices.resize(nCands);
+    for(auto array : {&etas, &phis, &pts})              array->resize(nCands);
+    for(auto array : {&absPdgIds, &charges, &fromPVs})  array->resize(nCands);
+    std::vector<unsigned> position(cellOffsets.begin(), cellOffsets.end() - 1);
+    for(unsigned i = 0; i < nCands; ++i){
+        const pat::PackedCandidate& pfc = pfcands[i];
+        unsigned slot   = position[cells[i]]++;
+        indices[slot]   = i;
+        etas[slot]      = pfc.eta();
+        phis[slot]      = pfc.phi();
+        pts[slot]       = pfc.pt();
+        absPdgIds[slot] = abs(pfc.pdgId());
+        charges[slot]   = pfc.charge();
+        fromPVs[slot]   = pfc.fromPV();
+    }
+}
+
+
+void PFCandidateGrid::candidatesInCone(const double eta, const double phi, const double radius, std::vector<unsigned>& slots) const{
+    static const ConeKernel coneKernel = selectConeKernel();
+
+    slots.clear();
+    int etaFirst = etaCell(eta - radius - margin);
+    int etaLast  = etaCell(eta + radius + margin);
+    int phiFirst = phiCell(phi - radius - margin);
+    int phiLast  = phiCell(phi + radius + margin);
+    if(phiLast - phiFirst >= (int) nPhiCells - 1){                                                       //cone covers the full phi range
+        phiFirst = 0;
+        phiLast  = nPhiCells - 1;
+    }
+
+    const double maxDeltaR2 = (radius + margin)*(radius + margin);
+    for(int e = etaFirst; e <= etaLast; ++e){
+        for(int p = phiFirst; p <= phiLast; ++p){
+            int wrapped = p % (int) nPhiCells;
+            if(wrapped < 0) wrapped += nPhiCells;
+            unsigned cell = e*nPhiCells + wrapped;
+            coneKernel(etas.data(), phis.data(), cellOffsets[cell], cellOffsets[cell + 1], eta, phi, maxDeltaR2, slots);
+        }
+    }
+    std::sort(slots.begin(), slots.end(), [this](unsigned a, unsigned b){ return indices[a] < indices[b]; }); //restore the original order of the collection
+}
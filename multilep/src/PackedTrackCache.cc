@@ -0,0 +1,41 @@
+#include "heavyNeutrino/multilep/interface/PackedTrackCache.h"
+
+void PackedTrackCache::reset(const std::vector<pat::PackedCandidate>& packedCandidates, const reco::Vertex& vertex){
+    candidates     = packedCandidates.data();
+    nCandidates    = packedCandidates.size();
+    vertexPosition = vertex.position();
+    unpacked.assign(nCandidates, false);
+    tracks.resize(nCandidates);
+}
+
+
+const PackedTrackCache::Track& PackedTrackCache::track(const unsigned key){
+    if(!unpacked[key]){
+        unpack(candidates[key], tracks[key]);
+        unpacked[key] = true;
+    }
+    return tracks[key];
+}
+
+
+const PackedTrackCache::Track& PackedTrackCache::track(const pat::PackedCandidate& candidate){
+    if(&candidate >= candidates and &candidate < candidates + nCandidates) return track(&candidate - candidates);
+    unpack(candidate, uncached);
+    return uncached;
+}
+
+
+void PackedTrackCache::unpack(const pat::PackedCandidate& candidate, Track& track) const{
+    const reco::Track& pseudoTrack = candidate.pseudoTrack();
+    track.pt                     = pseudoTrack.pt();
+    track.px                     = pseudoTrack.px();
+    track.py                     = pseudoTrack.py();
+    track.pz                     = pseudoTrack.pz();
+    track.p                      = pseudoTrack.p();
+    track.charge                 = pseudoTrack.charge();
+    track.dxy                    = pseudoTrack.dxy(vertexPosition);
+    track.dz                     = pseudoTrack.dz(vertexPosition);
+    track.numberOfValidHits      = pseudoTrack.hitPattern().numberOfValidHits();
+    track.numberOfValidPixelHits = pseudoTrack.hitPattern().numberOfValidPixelHits();
+    track.normalizedChi2         = pseudoTrack.normalizedChi2();
+}
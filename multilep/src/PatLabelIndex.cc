@@ -0,0 +1,42 @@
+#include "heavyNeutrino/multilep/interface/PatLabelIndex.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+PatLabelIndex::PatLabelIndex(const std::vector<std::string>& labelList, const Lookup lookupType):
+    labels(labelList),
+    lookup(lookupType),
+    indices(labelList.size(), -1)
+{}
+
+
+void PatLabelIndex::validate(const LabelValues& pairs){
+    bool valid = (pairs.size() == layoutSize);
+    for(unsigned l = 0; valid and l < labels.size(); ++l){
+        valid = indices[l] >= 0 and pairs[indices[l]].first == labels[l];
+    }
+    if(valid) return;
+
+    layoutSize = pairs.size();
+    for(unsigned l = 0; l < labels.size(); ++l) indices[l] = position(pairs, l);
+}
+
+
+int PatLabelIndex::position(const LabelValues& pairs, const unsigned label) const{
+    if(lookup == lastOrDefault){
+        for(int i = (int) pairs.size() - 1; i >= 0; --i){
+            if(pairs[i].first == labels[label]) return i;
+        }
+    } else {
+        for(unsigned i = 0; i < pairs.size(); ++i){
+            if(pairs[i].first == labels[label]) return i;
+        }
+    }
+    return -1;
+}
+
+
+float PatLabelIndex::find(const LabelValues& pairs, const unsigned label) const{
+    int i = position(pairs, label);
+    if(i >= 0)                  return pairs[i].second;
+    if(lookup == lastOrDefault) return -1000.;
+    throw cms::Exception("Key not found") << "Label " << labels[label] << " not found in the IDs of this object";
+}
@@ -2,15 +2,24 @@
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 #include "FWCore/ParameterSet/interface/FileInPath.h"
 #include "heavyNeutrino/multilep/interface/GenTools.h"
+
+#include <algorithm>
+
 /*
  * Calculating all photon-related variables
  */
 
+namespace {
+    enum PhotonId {cutBasedLoose, cutBasedMedium, cutBasedTight};                                         //IDs read through a PatLabelIndex, in the order of the label list
+    const std::vector<std::string> photonIdLabels = {"cutBasedPhotonID-Fall17-94X-V2-loose", "cutBasedPhotonID-Fall17-94X-V2-medium", "cutBasedPhotonID-Fall17-94X-V2-tight"};
+}
+
 
 PhotonAnalyzer::PhotonAnalyzer(const edm::ParameterSet& iConfig, multilep* multilepAnalyzer):
     chargedEffectiveAreas((iConfig.getParameter<edm::FileInPath>("photonsChargedEffectiveAreas")).fullPath()),
     neutralEffectiveAreas((iConfig.getParameter<edm::FileInPath>("photonsNeutralEffectiveAreas")).fullPath()),
     photonsEffectiveAreas((iConfig.getParameter<edm::FileInPath>("photonsPhotonsEffectiveAreas")).fullPath()),
+    photonIds(photonIdLabels),
     multilepAnalyzer(multilepAnalyzer)
 {};
 
@@ -58,10 +67,36 @@ void PhotonAnalyzer::beginJob(TTree* outputTree){
 }
 
 
-bool PhotonAnalyzer::analyze(const edm::Event& iEvent){
+/*
+ * Selection phase: count the preselected photons to decide on the photon skims
+ */
+bool PhotonAnalyzer::passSkim(const edm::Event& iEvent) const{
+    unsigned minPhotons = 0;
+    if(multilepAnalyzer->skim == "ttg")          minPhotons = 1;
+    if(multilepAnalyzer->skim == "singlephoton") minPhotons = 1;
+    if(multilepAnalyzer->skim == "diphoton")     minPhotons = 2;
+    if(minPhotons == 0) return true;
+
+    edm::Handle<std::vector<pat::Photon>> photons;                   iEvent.getByToken(multilepAnalyzer->photonToken,                       photons);
+    unsigned nPhotons = 0;
+    for(const pat::Photon& photon : *photons){
+        if(isPreselected(photon) and ++nPhotons >= minPhotons) return true;
+    }
+    return false;
+}
+
+bool PhotonAnalyzer::isPreselected(const pat::Photon& photon) const{
+    if(photon.pt()  < 10)        return false;
+    if(fabs(photon.eta()) > 2.5) return false;
+    return true;
+}
+
+/*
+ * Fill phase: all photon variables, only run for events passing the skim
+ */
+void PhotonAnalyzer::analyze(const edm::Event& iEvent){
     edm::Handle<std::vector<pat::Photon>> photons;                   iEvent.getByToken(multilepAnalyzer->photonToken,                       photons);
     edm::Handle<std::vector<pat::PackedCandidate>> packedCands;      iEvent.getByToken(multilepAnalyzer->packedCandidatesToken,             packedCands);
-    edm::Handle<std::vector<reco::Vertex>> vertices;                 iEvent.getByToken(multilepAnalyzer->vtxToken,                          vertices);
     edm::Handle<std::vector<pat::Electron>> electrons;               iEvent.getByToken(multilepAnalyzer->eleToken,                          electrons);
     edm::Handle<std::vector<pat::Muon>> muons;                       iEvent.getByToken(multilepAnalyzer->muonToken,                         muons);
     edm::Handle<std::vector<pat::Jet>> jets;                         iEvent.getByToken(multilepAnalyzer->jetToken,                          jets);
@@ -70,26 +105,26 @@ bool PhotonAnalyzer::analyze(const edm::Event& iEvent){
 
     // Loop over photons
     _nPh = 0;
+    if(!photons->empty()) photonIds.validate(photons->front().photonIDs());                            // ID positions, only resolved again when the layout changed
     for(auto photon = photons->begin(); photon != photons->end(); ++photon){
         if(_nPh == nPhoton_max) break;
         const auto photonRef = edm::Ref<std::vector<pat::Photon>>(photons, (photon - photons->begin()));
 
-        if(photon->pt()  < 10)        continue;
-        if(fabs(photon->eta()) > 2.5) continue;
+        if(!isPreselected(*photon))   continue;
         double rhoCorrCharged      = (*rho)*chargedEffectiveAreas.getEffectiveArea(photon->superCluster()->eta());
         double rhoCorrNeutral      = (*rho)*neutralEffectiveAreas.getEffectiveArea(photon->superCluster()->eta());
         double rhoCorrPhotons      = (*rho)*photonsEffectiveAreas.getEffectiveArea(photon->superCluster()->eta());
 
-        double randomConeIsoUnCorr = randomConeIso(photon->superCluster()->eta(), packedCands, *(vertices->begin()), electrons, muons, jets, photons);
+        double randomConeIsoUnCorr = randomConeIso(photon->superCluster()->eta(), packedCands, electrons, muons, jets, photons);
 
         _phPt[_nPh]                         = photon->pt();
         _phEta[_nPh]                        = photon->eta();
         _phEtaSC[_nPh]                      = photon->superCluster()->eta();
         _phPhi[_nPh]                        = photon->phi();
         _phE[_nPh]                          = photon->energy();
-        _phCutBasedLoose[_nPh]              = photon->photonID("cutBasedPhotonID-Fall17-94X-V2-loose");
-        _phCutBasedMedium[_nPh]             = photon->photonID("cutBasedPhotonID-Fall17-94X-V2-medium");
-        _phCutBasedTight[_nPh]              = photon->photonID("cutBasedPhotonID-Fall17-94X-V2-tight");
+        _phCutBasedLoose[_nPh]              = photonIds.value(photon->photonIDs(), cutBasedLoose);
+        _phCutBasedMedium[_nPh]             = photonIds.value(photon->photonIDs(), cutBasedMedium);
+        _phCutBasedTight[_nPh]              = photonIds.value(photon->photonIDs(), cutBasedTight);
         _phMva[_nPh]                        = photon->userFloat("PhotonMVAEstimatorRunIIFall17v2Values");
 
         _phRandomConeChargedIsolation[_nPh] = randomConeIsoUnCorr < 0 ? -1 : std::max(0., randomConeIsoUnCorr - rhoCorrCharged); // keep -1 when randomConeIso algorithm failed
@@ -107,16 +142,16 @@ bool PhotonAnalyzer::analyze(const edm::Event& iEvent){
         // https://twiki.cern.ch/twiki/bin/viewauth/CMS/EgammaMiniAODV2#Energy_Scale_and_Smearing
         // Currently only available for 2016/2017
         if(!multilepAnalyzer->is2018){
-          _phPtCorr[_nPh]                   = photon->pt()*photon->userFloat("ecalEnergyPostCorr")/photon->energy();
-          _phPtScaleUp[_nPh]                = photon->pt()*photon->userFloat("energyScaleUp")/photon->energy();
-          _phPtScaleDown[_nPh]              = photon->pt()*photon->userFloat("energyScaleDown")/photon->energy();
-          _phPtResUp[_nPh]                  = photon->pt()*photon->userFloat("energySigmaUp")/photon->energy();
-          _phPtResDown[_nPh]                = photon->pt()*photon->userFloat("energySigmaDown")/photon->energy();
           _phECorr[_nPh]                    = photon->userFloat("ecalEnergyPostCorr");
           _phEScaleUp[_nPh]                 = photon->userFloat("energyScaleUp");
           _phEScaleDown[_nPh]               = photon->userFloat("energyScaleDown");
           _phEResUp[_nPh]                   = photon->userFloat("energySigmaUp");
           _phEResDown[_nPh]                 = photon->userFloat("energySigmaDown");
+          _phPtCorr[_nPh]                   = photon->pt()*_phECorr[_nPh]/photon->energy();
+          _phPtScaleUp[_nPh]                = photon->pt()*_phEScaleUp[_nPh]/photon->energy();
+          _phPtScaleDown[_nPh]              = photon->pt()*_phEScaleDown[_nPh]/photon->energy();
+          _phPtResUp[_nPh]                  = photon->pt()*_phEResUp[_nPh]/photon->energy();
+          _phPtResDown[_nPh]                = photon->pt()*_phEResDown[_nPh]/photon->energy();
         }
 
         if(!multilepAnalyzer->isData){
@@ -125,11 +160,6 @@ bool PhotonAnalyzer::analyze(const edm::Event& iEvent){
         }
         ++_nPh;
     }
-
-    if(multilepAnalyzer->skim == "ttg" and _nPh < 1) return false;
-    if(multilepAnalyzer->skim == "singlephoton" and _nPh < 1) return false;
-    if(multilepAnalyzer->skim == "diphoton" and _nPh < 2) return false;
-    return true;
 }
 
 void PhotonAnalyzer::fillPhotonGenVars(const reco::GenParticle* genParticle){
@@ -144,7 +174,7 @@ void PhotonAnalyzer::fillPhotonGenVars(const reco::GenParticle* genParticle){
 
 
 
-double PhotonAnalyzer::randomConeIso(double eta, edm::Handle<std::vector<pat::PackedCandidate>>& pfcands, const reco::Vertex& vertex,
+double PhotonAnalyzer::randomConeIso(double eta, edm::Handle<std::vector<pat::PackedCandidate>>& pfcands,
         edm::Handle<std::vector<pat::Electron>>& electrons, edm::Handle<std::vector<pat::Muon>>& muons,
         edm::Handle<std::vector<pat::Jet>>& jets, edm::Handle<std::vector<pat::Photon>>& photons){
 
@@ -166,17 +196,22 @@ double PhotonAnalyzer::randomConeIso(double eta, edm::Handle<std::vector<pat::Pa
 
     // Calculate chargedIsolation
     float chargedIsoSum = 0;
-    for(auto& iCand : *pfcands){
+    const PFCandidateGrid& grid = multilepAnalyzer->pfCandidateGrid;
+    std::vector<unsigned> candidatesInCone;
+    grid.candidatesInCone(eta, randomPhi, 0.3, candidatesInCone);
+    for(unsigned i : candidatesInCone){
+        const pat::PackedCandidate& iCand = (*pfcands)[grid.index(i)];
         if(iCand.hasTrackDetails()){
-            if(deltaR(eta, randomPhi, iCand.eta(), iCand.phi()) > 0.3) continue;
-            if(abs(iCand.pdgId()) != 211) continue;
+            if(deltaR(eta, randomPhi, grid.eta(i), grid.phi(i)) > 0.3) continue;
+            if(grid.absPdgId(i) != 211) continue;
 
-            float dxy = iCand.pseudoTrack().dxy(vertex.position());
-            float dz  = iCand.pseudoTrack().dz(vertex.position());
+            const PackedTrackCache::Track& track = multilepAnalyzer->packedTrackCache.track(grid.index(i));
+            float dxy = track.dxy;
+            float dz  = track.dz;
             if(fabs(dxy) > 0.1) continue;
             if(fabs(dz) > 0.2)  continue;
 
-            chargedIsoSum += iCand.pt();
+            chargedIsoSum += grid.pt(i);
         }
     }
     return chargedIsoSum;
@@ -193,8 +228,11 @@ void PhotonAnalyzer::matchCategory(const pat::Photon& photon, edm::Handle<std::v
     float minDeltaR = 999;
     const reco::GenParticle* matched = nullptr;
 
-    for(auto& p : *genParticles){
-      if(p.status()!=1 and p.status()!=71)  continue;
+    std::vector<unsigned> candidates;                                        //status 1 or 71 in an eta window around the photon, in the order of the collection
+    multilepAnalyzer->genEventView.photonMatchingCandidates(photon.eta(), 0.1, candidates);
+    std::sort(candidates.begin(), candidates.end());
+    for(unsigned index : candidates){
+      const reco::GenParticle& p = (*genParticles)[index];
       if(fabs(p.pt()-photon.pt())/p.pt() > 0.5) continue;
       float myDeltaR = deltaR(p.eta(), p.phi(), photon.eta(), photon.phi());
       if(myDeltaR > 0.1 or myDeltaR > minDeltaR) continue;
@@ -205,8 +243,8 @@ void PhotonAnalyzer::matchCategory(const pat::Photon& photon, edm::Handle<std::v
     if(matched){
       _phTTGMatchPt[_nPh]  = matched->pt();
       _phTTGMatchEta[_nPh] = matched->eta();
-      bool passParentage   = GenTools::passParentage(*matched, *genParticles);
-      float minOtherDeltaR = GenTools::getMinDeltaR(*matched, *genParticles);
+      bool passParentage   = GenTools::passParentage(*matched, multilepAnalyzer->genAncestry);
+      float minOtherDeltaR = GenTools::getMinDeltaR(*matched, multilepAnalyzer->genEventView);
       if(matched and matched->pdgId() == 22){
         if(passParentage and minOtherDeltaR > 0.2)       _phTTGMatchCategory[_nPh] = GENUINE;
         else                                             _phTTGMatchCategory[_nPh] = HADRONICPHOTON;
@@ -8,12 +8,16 @@ SUSYMassAnalyzer::SUSYMassAnalyzer(const edm::ParameterSet& iConfig, multilep* m
 {};
 
 
-void SUSYMassAnalyzer::beginJob(TTree* outputTree, edm::Service<TFileService>& fs){
+void SUSYMassAnalyzer::beginJob(TTree* outputTree, const OutputMerger& outputMerger){
     if(!multilepAnalyzer->isSUSY) return;    //only run this module on SUSY samples
     //Counter to determine the amount of events for every SUSY mass point
     //Note, too small binning is used to be sure the binning is smaller than the sample's mass point separation
     //There is no way to access the amount of mass points or there splitting while running over the sample!!!
-    hCounterSUSY = fs->make<TH2D>("hCounterSUSY", "SUSY Events counter", 400,0,2000, 300, 0, 1500);
+    //Booked and filled by the counter instance of multilep only, which runs on all events
+    if(multilepAnalyzer->countersOnly){
+        hCounterSUSY = outputMerger.make<TH2D>("hCounterSUSY", "SUSY Events counter", 400,0,2000, 300, 0, 1500);
+        return;
+    }
     //Store SUSY particle masses for event
     outputTree->Branch("_mChi1", &_mChi1, "_mChi1/D");
     outputTree->Branch("_mChi2", &_mChi2, "_mChi2/D");
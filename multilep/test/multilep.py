@@ -11,6 +11,7 @@ inputFile       = 'file:///pnfs/iihe/cms/store/user/tomc/heavyNeutrino/testFiles
 
 # Other default arguments
 nEvents         = 1000
+nThreads        = 1
 extraContent    = ''
 outputFile      = 'noskim.root' # trilep    --> skim three leptons (basic pt/eta criteria)
                                 # dilep     --> skim two leptons
@@ -29,11 +30,13 @@ for i in range(1,len(sys.argv)):
     elif "inputFile"    in sys.argv[i]: inputFile    = getVal(sys.argv[i])
     elif "extraContent" in sys.argv[i]: extraContent = getVal(sys.argv[i])
     elif "events"       in sys.argv[i]: nEvents      = int(getVal(sys.argv[i]))
+    elif "threads"      in sys.argv[i]: nThreads     = int(getVal(sys.argv[i]))
 
 isData = not ('SIM' in inputFile or 'HeavyNeutrino' in inputFile)
 is2017 = "Run2017" in inputFile or "17MiniAOD" in inputFile
 is2018 = "Run2018" in inputFile or "18MiniAOD" in inputFile
 isSUSY = "SMS-T" in inputFile
+skim   = outputFile.split('/')[-1].split('.')[0].split('_')[0]
 
 process = cms.Process("BlackJackAndHookers")
 
@@ -42,7 +45,7 @@ process.load("FWCore.MessageLogger.MessageLogger_cfi")
 process.MessageLogger.cerr.FwkReport.reportEvery = 100
 
 process.source       = cms.Source("PoolSource", fileNames = cms.untracked.vstring(inputFile.split(",")))
-process.options      = cms.untracked.PSet(wantSummary = cms.untracked.bool(True))
+process.options      = cms.untracked.PSet(wantSummary = cms.untracked.bool(True), numberOfThreads = cms.untracked.uint32(nThreads), numberOfStreams = cms.untracked.uint32(0))
 process.maxEvents    = cms.untracked.PSet(input = cms.untracked.int32(nEvents))
 process.TFileService = cms.Service("TFileService", fileName = cms.string(outputFile))
 
@@ -71,7 +74,27 @@ if is2018:   setupEgammaPostRecoSeq(process, runEnergyCorrections=False, era='20
 elif is2017: setupEgammaPostRecoSeq(process, runEnergyCorrections=True,  era='2017-Nov17ReReco') # Rerun scale and smearings for shiftscale bug
 else:        setupEgammaPostRecoSeq(process, runEnergyCorrections=False, era='2016-Legacy')      # Default scale and smearings are ok
 
+#
+# Skim filter at the head of the path, so the egamma, jet and MET sequences only run on events which could pass the skim
+# (the ntuplizer is on the same path: the producers of these sequences run unscheduled, so they only run when a module behind the filter consumes them)
+# Uses the slimmed collections from MiniAOD (i.e. before energy corrections and smearing), hence the looser pt thresholds
+#
+process.skimFilter = cms.EDFilter('multilepSkimFilter',
+  muons                         = cms.InputTag("slimmedMuons"),
+  electrons                     = cms.InputTag("slimmedElectrons", "", "@skipCurrentProcess"),
+  taus                          = cms.InputTag("slimmedTaus"),
+  photons                       = cms.InputTag("slimmedPhotons", "", "@skipCurrentProcess"),
+  jets                          = cms.InputTag("slimmedJets"),
+  skim                          = cms.untracked.string(skim),
+  muonPtMin                     = cms.double(5),
+  electronPtMin                 = cms.double(5),
+  tauPtMin                      = cms.double(20),
+  photonPtMin                   = cms.double(8),
+  jetPtMin                      = cms.double(10),
+)
+
 # Main Process
+from heavyNeutrino.multilep.leptonIds_cff import getLeptonIds
 process.blackJackAndHookers = cms.EDAnalyzer('multilep',
   vertices                      = cms.InputTag("goodOfflinePrimaryVertices"),
   genEventInfo                  = cms.InputTag("generator"),
@@ -95,6 +118,9 @@ process.blackJackAndHookers = cms.EDAnalyzer('multilep',
   leptonMvaWeightsMutZqTTV16    = cms.FileInPath("heavyNeutrino/multilep/data/mvaWeights/mu_tZqTTV16_BDTG.weights.xml"),
   leptonMvaWeightsEletZqTTV17   = cms.FileInPath("heavyNeutrino/multilep/data/mvaWeights/el_tZqTTV17_BDTG.weights.xml"),
   leptonMvaWeightsMutZqTTV17    = cms.FileInPath("heavyNeutrino/multilep/data/mvaWeights/mu_tZqTTV17_BDTG.weights.xml"),
+  leptonMvas                    = cms.vstring('SUSY16', 'TTH16', 'SUSY17', 'TTH17', 'tZqTTV16', 'tZqTTV17'), # trainings to store, SUSY16 is always evaluated for the ewkino ids
+  validateLeptonMvas            = cms.untracked.bool('validateLeptonMvas' in extraContent),               # compare every lepton MVA with TMVA::Reader (slow, used by test/testing/runTests.py)
+  leptonIds                     = getLeptonIds(is2017, is2018),                                            # HN and ewkino working points, see python/leptonIds_cff.py
   JECtxtPath                    = cms.FileInPath("heavyNeutrino/multilep/data/JEC/dummy.txt"),
   photons                       = cms.InputTag("slimmedPhotons"),
   photonsChargedEffectiveAreas  = cms.FileInPath('RecoEgamma/PhotonIdentification/data/Fall17/effAreaPhotons_cone03_pfChargedHadrons_90percentBased_V2.txt'),
@@ -105,16 +131,19 @@ process.blackJackAndHookers = cms.EDAnalyzer('multilep',
   rho                           = cms.InputTag("fixedGridRhoFastjetAll"),
   met                           = cms.InputTag("slimmedMETs"),
   jets                          = cms.InputTag("selectedUpdatedPatJetsUpdatedJEC"),
-  jetsSmeared                   = cms.InputTag("selectedUpdatedPatJetsUpdatedJEC" if isData else "slimmedJetsCorrectedAndSmeared"),
-  jetsSmearedUp                 = cms.InputTag("selectedUpdatedPatJetsUpdatedJEC" if isData else "slimmedJetsCorrectedAndSmearedUp"),
-  jetsSmearedDown               = cms.InputTag("selectedUpdatedPatJetsUpdatedJEC" if isData else "slimmedJetsCorrectedAndSmearedDown"),
+  jetsSmearedPt                 = cms.InputTag("jetSmearing:pt"),                                          # not used on data, where the smeared pt is the jet pt
+  jetsSmearedPtUp               = cms.InputTag("jetSmearing:ptUp"),
+  jetsSmearedPtDown             = cms.InputTag("jetSmearing:ptDown"),
   jecUncertaintyFile16          = cms.FileInPath("heavyNeutrino/multilep/data/JEC/Summer16_07Aug2017_V9_MC_Uncertainty_AK4PFchs.txt"),
   jecUncertaintyFile17          = cms.FileInPath("heavyNeutrino/multilep/data/JEC/Fall17_17Nov2017_V6_MC_Uncertainty_AK4PFchs.txt"), # TODO: add 2018
+  jecUncertaintyFile16Sources   = cms.FileInPath("heavyNeutrino/multilep/data/JEC/Summer16_07Aug2017_V9_MC_UncertaintySources_AK4PFchs.txt"),
+  jecUncertaintyFile17Sources   = cms.FileInPath("heavyNeutrino/multilep/data/JEC/Fall17_17Nov2017_V6_MC_UncertaintySources_AK4PFchs.txt"),
+  jecUncertaintySources         = cms.vstring(),                                                           # split JEC sources (e.g. 'FlavorQCD') for which _jetPt_JEC<source>Down/Up are stored
   prescales                     = cms.InputTag("patTrigger"),
   triggers                      = cms.InputTag("TriggerResults::HLT"),
   recoResultsPrimary            = cms.InputTag("TriggerResults::PAT"),
   recoResultsSecondary          = cms.InputTag("TriggerResults::RECO"),
-  skim                          = cms.untracked.string(outputFile.split('/')[-1].split('.')[0].split('_')[0]),
+  skim                          = cms.untracked.string(skim),
   isData                        = cms.untracked.bool(isData),
   is2017                        = cms.untracked.bool(is2017),
   is2018                        = cms.untracked.bool(is2018),
@@ -132,8 +161,18 @@ if isData:
   jsonDir = os.path.expandvars('$CMSSW_BASE/src/heavyNeutrino/multilep/data/JSON')
   process.source.lumisToProcess = LumiList.LumiList(filename = os.path.join(jsonDir, getJSON(is2017, is2018))).getVLuminosityBlockRange()
 
+# Second instance which only fills the event counters (hCounter, lheCounter, nVertices,...) for all events, including those rejected by the skim filter
+# It consumes nothing from the egamma, jet and MET sequences and books its histograms next to the tree of the ntuplizer
+process.blackJackAndHookersCounters = process.blackJackAndHookers.clone(
+  countersOnly                  = cms.untracked.bool(True),
+  counterDirectory              = cms.untracked.string('blackJackAndHookers'),
+)
+
 process.p = cms.Path(process.goodOfflinePrimaryVertices *
+                     process.skimFilter *
                      process.egammaPostRecoSeq *
                      process.jetSequence *
                      process.fullPatMetSequence *
                      process.blackJackAndHookers)
+
+process.e = cms.EndPath(process.blackJackAndHookersCounters)
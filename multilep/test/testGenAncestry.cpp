@@ -0,0 +1,69 @@
+/*
+ * Decay chain summaries of GenAncestry compared with the values of the original std::set based decay chain (GenTools::setDecayChain before
+ * GenAncestry), for chains with protons and antiprotons: protons were never inserted in the chain, antiprotons were, but never counted as
+ * light baryon (unlike antineutrons). Run with scram b runtests
+ */
+#include "heavyNeutrino/multilep/interface/GenAncestry.h"
+#include "heavyNeutrino/multilep/interface/GenTools.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+    enum Particle {proton, antiproton, antineutron, electronFromProton, electronFromAntiproton, electronFromBoth, electronFromAntineutron, nParticles};
+
+    struct Expected {
+        Particle    particle;
+        std::string description;
+        bool        passParentage;
+        unsigned    provenanceCompressed;
+        unsigned    provenance;                                                                          //16: pi_0 (uds in the chain), 18: F_L
+    };
+
+    //values of the std::set based decay chain
+    const std::vector<Expected> expectations = {{proton,                 "proton (empty chain)",          true,  4, 18},
+                                                {antiproton,             "antiproton",                    false, 3, 18},
+                                                {electronFromProton,     "electron from a proton",        true,  3, 18},
+                                                {electronFromAntiproton, "electron from an antiproton",   false, 3, 18},
+                                                {electronFromBoth,       "electron from p and pbar",      false, 3, 18},
+                                                {electronFromAntineutron,"electron from an antineutron",  false, 3, 16}};
+
+    reco::GenParticle makeParticle(const int pdgId){
+        return reco::GenParticle(0, reco::Particle::LorentzVector(0., 0., 10., 10.), reco::Particle::Point(0., 0., 0.), pdgId, 1, true);
+    }
+}
+
+int main(){
+    std::vector<reco::GenParticle> genParticles;
+    genParticles.reserve(nParticles);                                                                    //the mother references point into the collection
+    genParticles.push_back(makeParticle(2212));
+    genParticles.push_back(makeParticle(-2212));
+    genParticles.push_back(makeParticle(-2112));
+    genParticles.push_back(makeParticle(11));
+    genParticles.push_back(makeParticle(11));
+    genParticles.push_back(makeParticle(11));
+    genParticles.push_back(makeParticle(11));
+    genParticles[electronFromProton].addMother(reco::GenParticleRef(&genParticles, proton));
+    genParticles[electronFromAntiproton].addMother(reco::GenParticleRef(&genParticles, antiproton));
+    genParticles[electronFromBoth].addMother(reco::GenParticleRef(&genParticles, proton));
+    genParticles[electronFromBoth].addMother(reco::GenParticleRef(&genParticles, antiproton));
+    genParticles[electronFromAntineutron].addMother(reco::GenParticleRef(&genParticles, antineutron));
+
+    GenAncestry ancestry;
+    ancestry.fill(genParticles);
+
+    unsigned failures = 0;
+    for(const Expected& expected : expectations){
+        const reco::GenParticle& gen = genParticles[expected.particle];
+        const bool     passParentage        = GenTools::passParentage(gen, ancestry);
+        const unsigned provenanceCompressed = GenTools::provenanceCompressed(&gen, ancestry, false);
+        const unsigned provenance           = GenTools::provenance(&gen, ancestry);
+        const bool     ok = passParentage == expected.passParentage and provenanceCompressed == expected.provenanceCompressed and provenance == expected.provenance;
+        if(!ok) ++failures;
+        std::cout << "testGenAncestry: " << expected.description << ": passParentage " << passParentage << " (expected " << expected.passParentage << "), provenanceCompressed "
+                  << provenanceCompressed << " (expected " << expected.provenanceCompressed << "), provenance " << provenance << " (expected " << expected.provenance << ")"
+                  << (ok ? "" : " --> FAILED") << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
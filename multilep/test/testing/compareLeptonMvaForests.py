@@ -0,0 +1,89 @@
+#!/usr/bin/env python
+#
+# Compares the native lepton MVA forests (LeptonMvaForest, through bin/evaluateLeptonMvaForest) with an independent evaluation which follows
+# TMVA::Reader::EvaluateMVA for the BDTG weight files: -999 for NaN inputs, DecisionTreeNode::GoesRight on float inputs and cuts,
+# float leaf responses summed in double and MethodBDT::GetGradBoostMVA. The weight files are read with a standard xml parser.
+# The leptons are random, plus leptons with one variable exactly on, just below and just above every cut value of the forest
+# Usage: compareLeptonMvaForests.py [weight files], by default all weight files in data/mvaWeights
+#
+from __future__ import print_function
+import glob, math, os, random, struct, subprocess, sys, tempfile
+import xml.etree.ElementTree as ElementTree
+
+def toFloat(x):
+  return struct.unpack('f', struct.pack('f', x))[0]
+
+def nextFloat(x, direction):                                                      # neighbouring float32 value
+  bits = struct.unpack('i', struct.pack('f', x))[0]
+  if x == 0: return toFloat(direction*1e-45)
+  bits += direction if x > 0 else -direction
+  return struct.unpack('f', struct.pack('i', bits))[0]
+
+# Trees as nested tuples (variable, cut, cutType, left, right) with float leaf responses
+def readNode(node):
+  if node.get('nType') != '0': return toFloat(float(node.get('res')))
+  children = dict((child.get('pos'), child) for child in node.findall('Node'))
+  return (int(node.get('IVar')), toFloat(float(node.get('Cut'))), node.get('cType') == '1', readNode(children['l']), readNode(children['r']))
+
+def readForest(weightFile):
+  root      = ElementTree.parse(weightFile).getroot()
+  variables = [variable.get('Expression') for variable in root.find('Variables').findall('Variable')]
+  trees     = [readNode(tree.find('Node')) for tree in root.find('Weights').findall('BinaryTree')]
+  return variables, trees
+
+def evaluate(trees, values):
+  if any(math.isnan(value) for value in values): return -999.
+  total = 0.
+  for node in trees:
+    while isinstance(node, tuple):
+      variable, cut, cutType, left, right = node
+      goesRight = (values[variable] >= cut) == cutType
+      node = right if goesRight else left
+    total += node
+  return 2.0/(1.0+math.exp(-2.0*total))-1
+
+def cutValues(node, cuts):
+  if not isinstance(node, tuple): return
+  cuts.add((node[0], node[1]))
+  cutValues(node[3], cuts)
+  cutValues(node[4], cuts)
+
+def compare(weightFile, nRandom = 2000, nEdges = 3000):
+  variables, trees = readForest(weightFile)
+  cuts = set()
+  for tree in trees: cutValues(tree, cuts)
+  cuts = sorted(cuts)
+
+  random.seed(12345)
+  perVariable = [[cut for v, cut in cuts if v == variable] or [0.] for variable in range(len(variables))]
+  def randomLepton():
+    return [toFloat(random.choice(values) + random.gauss(0., 1. + abs(random.choice(values)))) for values in perVariable]
+
+  leptons = [randomLepton() for i in range(nRandom)]
+  for variable, cut in random.sample(cuts, min(nEdges, len(cuts))):
+    for value in (cut, nextFloat(cut, -1), nextFloat(cut, +1)):
+      lepton = randomLepton()
+      lepton[variable] = value
+      leptons.append(lepton)
+  for i in range(20):
+    lepton = randomLepton()
+    lepton[i % len(variables)] = float('nan')
+    leptons.append(lepton)
+
+  featureFile  = tempfile.NamedTemporaryFile(suffix='.features', delete=False)
+  responseFile = featureFile.name.replace('.features', '.responses')
+  featureFile.write(struct.pack('%df' % (len(leptons)*len(variables)), *[lepton[v] for v in range(len(variables)) for lepton in leptons]))
+  featureFile.close()
+  subprocess.check_call(['evaluateLeptonMvaForest', weightFile, featureFile.name, responseFile])
+  with open(responseFile, 'rb') as f: native = struct.unpack('%dd' % len(leptons), f.read())
+  os.remove(featureFile.name)
+  os.remove(responseFile)
+
+  differences = [(lepton, n, evaluate(trees, lepton)) for lepton, n in zip(leptons, native) if n != evaluate(trees, lepton)]
+  for lepton, n, reference in differences[:10]: print('   ', lepton, ':', repr(n), 'vs', repr(reference), '(reference)')
+  print('compareLeptonMvaForests: %s: %d trees, %d leptons (%d on or next to cut values), %d differences' % (os.path.basename(weightFile), len(trees), len(leptons), 3*min(nEdges, len(cuts)), len(differences)))
+  return len(differences) == 0
+
+weightFiles = sys.argv[1:] or sorted(glob.glob(os.path.join(os.path.dirname(os.path.abspath(__file__)), '../../data/mvaWeights/*.weights.xml')))
+identical   = [compare(weightFile) for weightFile in weightFiles]
+sys.exit(0 if all(identical) else 1)
@@ -46,19 +46,30 @@ def compare(logger, name):
 
 # Compile
 print system('eval `scram runtime -sh`;cd $CMSSW_BASE/src;scram b -j 10')
+print system('eval `scram runtime -sh`;makeLeptonMvaCache $CMSSW_BASE/src/heavyNeutrino/multilep/data/mvaWeights/*.weights.xml')
 
 # Starting the test
 with open('tests.log', 'w') as logFile:
   logFile.write(system("eval `scram runtime -sh`;git log -n 1;git diff -- . ':(exclude)*.log'"))
 
+  logFile.write('\n--------------------------------------------------------------------------------------------------\n\n')
+  try:    logFile.write(system('eval `scram runtime -sh`;python compareLeptonMvaForests.py'))   # lepton MVA forests against the TMVA evaluation rules
+  except subprocess.CalledProcessError, e: logFile.write('compareLeptonMvaForests --> FAILED\n' + e.output)
+  try:    logFile.write(system('eval `scram runtime -sh`;cd $CMSSW_BASE/src/heavyNeutrino/multilep;scram b runtests'))   # unit tests in test/BuildFile.xml
+  except subprocess.CalledProcessError, e: logFile.write('scram b runtests --> FAILED\n' + e.output)
+  try:    logFile.write(system('eval `scram runtime -sh`;validateJetCorrections'))     # JEC class against FactorizedJetCorrector for the shipped text files
+  except subprocess.CalledProcessError, e: logFile.write('validateJetCorrections --> FAILED\n' + e.output)
+
   def runTest(name, testFile):
     logFile.write('\n--------------------------------------------------------------------------------------------------\n\n')
-    command = 'eval `scram runtime -sh`;cmsRun ../multilep.py inputFile=' + testFile + ' outputFile=noskim.root events=100 extraContent=storeLheParticles'
+    command = 'eval `scram runtime -sh`;cmsRun ../multilep.py inputFile=' + testFile + ' outputFile=noskim.root events=100 extraContent=storeLheParticles,validateLeptonMvas'
     logFile.write('Running test: ' + name)
     try:    
-      system(command)
+      output = system(command)
       system('mv noskim.root ' + name + '.root')
       logFile.write( ' --> OK\n')
+      for line in output.splitlines():                                        # lepton MVA comparison with TMVA::Reader and timing (validateLeptonMvas)
+        if line.startswith('LeptonMvaHelper:'): logFile.write('   ' + line + '\n')
       compare(logFile, name)
       system('mv ' + name + '.root ' + name + '-ref.root')
     except subprocess.CalledProcessError, e:
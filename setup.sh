@@ -36,5 +36,6 @@ fi
 # Compile and move into package
 cd $CMSSW_BASE
 scram b -j 10
+makeLeptonMvaCache $CMSSW_BASE/src/heavyNeutrino/multilep/data/mvaWeights/*.weights.xml # read-only caches of the lepton MVA forests
 cd $CMSSW_BASE/src/heavyNeutrino
 echo "Setup finished"